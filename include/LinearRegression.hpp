@@ -1,27 +1,27 @@
 #pragma once
 #include "Model.hpp"
 #include "utils/Dataset.hpp"
-#include "xtensor/containers/xarray.hpp"
+#include "xtensor/containers/xtensor.hpp"
 
 class LinearRegression : public Model {
 public:
-    LinearRegression(Dataset &, bool, size_t);
+    LinearRegression(Dataset &, bool, size_t, Communicator * = nullptr);
     LinearRegression(Dataset &, bool);
     LinearRegression(Dataset &, size_t);
     LinearRegression(Dataset &);
-
-    ~LinearRegression() {
-        delete_feat_bias();
-        delete_y_label();
-    }
+    explicit LinearRegression(const std::string &);
 
     inline double getYMean() const { return y_norm.mean; }
     inline double getYSTD() const { return y_norm.std; }
+    inline bool labelsNormalized() const { return normalizeLabels; }
 
-    static double MSE(const model_arr &, const model_arr &);
-    static double SSE(const model_arr &, const model_arr &);
+    template<typename A>
+    static double MSE(const A &, const A &);
+    template<typename A>
+    static double SSE(const A &, const A &);
     void train(size_t, double);
-    model_arr output_raw(model_arr);
-    model_arr output(model_arr);
-    model_arr operator()(model_arr);
+    bool save(const std::string &) const;
+    model_arr output_raw(const model_arr &) const;
+    model_arr output(const model_arr &) const;
+    model_arr operator()(const model_arr &) const;
 };
\ No newline at end of file
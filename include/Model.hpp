@@ -1,11 +1,23 @@
 #pragma once
 #include "utils/Dataset.hpp"
+#include "utils/Communicator.hpp"
+#include "utils/MemoryPool.hpp"
+#include <cmath>
+#include <array>
+#include <memory>
+#include <string>
 #include <unordered_map>
-#include "xtensor/containers/xarray.hpp"
+#include <vector>
+#include "xtensor/containers/xtensor.hpp"
+#include "xtensor/containers/xfixed.hpp"
 #include "xtensor/views/xview.hpp"
 #include "xtensor/core/xoperation.hpp"
+#include "xtensor/containers/xadapt.hpp"
+#include "xtensor-blas/xlinalg.hpp"
+#include "xtensor-blas/xblas.hpp"
 
-typedef xt::xarray<double> model_arr;
+typedef xt::xtensor<double, 2> model_arr;
+typedef xt::xtensor<double, 2, xt::layout_type::row_major, ML::PoolAllocator<double>> train_arr;     // Training data and epoch buffers, allocated from Model::pool
 
 namespace ML {
 
@@ -26,8 +38,8 @@ struct ZScaleNormalizer {
     ZScaleNormalizer() = default;
 };
 
-template<typename T>
-inline bool xarray_same_shape(xt::xarray<T> a1, xt::xarray<T> a2) {
+template<typename E1, typename E2>
+inline bool same_shape(const E1 &a1, const E2 &a2) {
     bool differentShape = a1.shape().size() != a2.shape().size();
     if(differentShape) { std::cerr << "Different number of dimensions!\n"; return false; }
     for(int i = 0; i < a1.shape().size(); i += 1) {
@@ -37,22 +49,111 @@ inline bool xarray_same_shape(xt::xarray<T> a1, xt::xarray<T> a2) {
     return true;
 }
 
+/**
+ * @brief Calculates z-score normalizer of a column.
+ * 
+ * Without a Communicator this is the mean and (population) standard deviation of `col`.
+ * With a Communicator `col` is the local shard and statistics are computed over all ranks,
+ * so every rank gets the normalizer a single process would compute on the full dataset.
+ * 
+ * @param col Column expression.
+ * @param comm Communicator or nullptr.
+ * @return ZScaleNormalizer of the column.
+ */
+template<typename E>
+inline ZScaleNormalizer column_normalizer(const E &col, Communicator *comm) {
+    if(comm == nullptr)
+        return ZScaleNormalizer(xt::mean(col)(), xt::stddev(col)());
+
+    double n = comm->allreduce_sum((double)col.size());
+    double mean = comm->allreduce_sum(xt::sum(col)()) / n;
+    double var = comm->allreduce_sum(xt::sum(xt::square(col - mean))()) / n;
+    return ZScaleNormalizer(mean, std::sqrt(var));
+}
+
+/**
+ * @brief 1-D view of a column vector for BLAS level 2 calls.
+ * 
+ * @param v Column vector (k, 1).
+ * @return Non-owning (k) view of the same memory.
+ */
+template<typename A>
+inline auto column_vector(A &v) {
+    return xt::adapt(v.data(), v.size(), xt::no_ownership(), std::array<size_t, 1>{ v.size() });
+}
+
 /**
  * @brief Adds bias column to feature array.
  * 
- * Takes xarray as input and adds a bias column to the beginning.
+ * Takes feature matrix as input and adds a bias column to the beginning.
  * Bias column filled with ones.
  * 
- * @param features Feature xarray.
- * @return New xarray with bias column before features.
+ * @tparam A Result container type (train_arr for training data).
+ * @param features Feature matrix (n, d).
+ * @return New matrix (n, d + 1) with bias column before features.
  */
-inline model_arr generate_feat_bias(model_arr &features) {
-    model_arr fb = xt::ones<double>({ (size_t)features.shape().at(0), (size_t)features.shape().at(1) + 1 });
-    for(size_t c = 0; c < features.shape().at(1); c += 1)
-        xt::col(fb, c + 1) = xt::col(features, c);
+template<typename A = model_arr, typename E>
+inline A generate_feat_bias(const E &features) {
+    A fb = A::from_shape({ (size_t)features.shape().at(0), (size_t)features.shape().at(1) + 1 });
+    xt::col(fb, 0) = 1.0;
+    xt::view(fb, xt::all(), xt::range((size_t)1, fb.shape().at(1))) = features;
     return std::move(fb);
 }
 
+/**
+ * @brief Calculates input_feat * weights with the number of columns fixed at compile time.
+ * 
+ * Weights are copied into an xtensor_fixed so the per-row dot product is fully unrolled.
+ * Input must be row-major with exactly D columns.
+ * 
+ * @param input_feat Feature matrix with bias column (n, D).
+ * @param weights Weights (D, 1).
+ * @return Model scores (n, 1).
+ */
+template<size_t D>
+inline model_arr linear_scores_fixed(const model_arr &input_feat, const model_arr &weights) {
+    xt::xtensor_fixed<double, xt::xshape<D>> w;
+    for(size_t k = 0; k < D; k += 1)
+        w(k) = weights(k, 0);
+
+    size_t n = input_feat.shape().at(0);
+    model_arr y = model_arr::from_shape({ n, (size_t)1 });
+    const double *row = input_feat.data();
+    for(size_t i = 0; i < n; i += 1, row += D) {
+        double s = 0.0;
+        for(size_t k = 0; k < D; k += 1)
+            s += row[k] * w(k);
+        y(i, 0) = s;
+    }
+    return std::move(y);
+}
+
+/**
+ * @brief Calculates input_feat * weights.
+ * 
+ * Small feature counts (bias included) dispatch to linear_scores_fixed,
+ * larger ones go through BLAS.
+ * 
+ * @param input_feat Feature matrix with bias column (n, d + 1).
+ * @param weights Weights (d + 1, 1).
+ * @return Model scores (n, 1).
+ */
+inline model_arr linear_scores(const model_arr &input_feat, const model_arr &weights) {
+    if(input_feat.shape().at(1) != weights.shape().at(0))
+        return xt::linalg::dot(input_feat, weights);
+
+    switch(weights.shape().at(0)) {
+        case 2: return linear_scores_fixed<2>(input_feat, weights);
+        case 3: return linear_scores_fixed<3>(input_feat, weights);
+        case 4: return linear_scores_fixed<4>(input_feat, weights);
+        case 5: return linear_scores_fixed<5>(input_feat, weights);
+        case 6: return linear_scores_fixed<6>(input_feat, weights);
+        case 7: return linear_scores_fixed<7>(input_feat, weights);
+        case 8: return linear_scores_fixed<8>(input_feat, weights);
+        default: return xt::linalg::dot(input_feat, weights);
+    }
+}
+
 /**
  * @brief Calculates R^2 value.
  * 
@@ -60,13 +161,13 @@ inline model_arr generate_feat_bias(model_arr &features) {
  * This can be used to evaluate model performance.
  * A R^2 value close to 1 indicates good performance.
  * 
- * @param y_lab xarray of expected/desired model output.
- * @param y xarray of model outputs.
+ * @param y_lab matrix of expected/desired model output.
+ * @param y matrix of model outputs.
  * @return R^2 value (double).
  */
 inline double R_Squared(const model_arr &y_lab, const model_arr &y) {
     // Make sure input shapes are the same
-    if(!xarray_same_shape(y_lab, y)) {
+    if(!same_shape(y_lab, y)) {
         std::cerr << "Cannot calculate loss! y_label and y_train have different dimensions!\n";
         return std::numeric_limits<double>::quiet_NaN();
     }
@@ -86,8 +187,8 @@ inline double R_Squared(const model_arr &y_lab, const model_arr &y) {
  * This can be used to evaluate model performance for classification models that output { -1, 1 }.
  * A accuracy value close to 1 indicates good performance.
  * 
- * @param y_lab xarray of expected/desired model output.
- * @param y xarray of model outputs.
+ * @param y_lab matrix of expected/desired model output.
+ * @param y matrix of model outputs.
  * @return accuracy value (double).
  */
 inline double accuracy(const model_arr &y_lab, const model_arr &y) {
@@ -101,14 +202,22 @@ typedef ML::ZScaleNormalizer ZScaleNormalizer;
 
 class Model {
 protected:
-    model_arr *y_label = nullptr;
-    model_arr *feat_bias = nullptr;         // (n, d + 1)
+    std::unique_ptr<ML::MemoryPool> pool;   // Backs y_label, feat_bias and the training buffers, so it is destroyed last
+    train_arr y_label;
+    train_arr feat_bias;                    // (n, d + 1)
     model_arr weights;                      // (d + 1, 1)
-    std::tuple<size_t, size_t> fb_shape;
+    model_arr score_weights;                // weights with feature normalizers folded in, applied to raw rows (d + 1, 1)
+    size_t n_samples = 0;                   // Rows across all ranks
+
+    Communicator *comm = nullptr;
+    bool good = true;
 
     bool normalizeLabels = false;
-    ZScaleNormalizer y_norm;
+    ZScaleNormalizer y_norm = ZScaleNormalizer(0.0, 1.0);
     std::unordered_map<size_t, ZScaleNormalizer> feat_norms;
+    std::vector<ZScaleNormalizer> feat_stats;                   // Raw statistics of every feat_bias column
+
+    Model() = default;
 
     /**
      * @brief Create Model from Dataset.
@@ -119,28 +228,40 @@ protected:
      * Also normalizes labels, adds bias column to feature matrix, initializes weights, stores label normalization information.
      * The first `start_norm - 1` columns of the Dataset feature matrix will not be normalized.
      * 
+     * With a Communicator, `d` is this rank's shard and normalization uses statistics over all ranks.
+     * isGood() is false if any rank has an empty shard.
+     * 
      * @param d Dataset object.
      * @param start_norm size_t: column index from which normalization will be applied.
+     * @param communicator Communicator for distributed training, nullptr for single process.
      */
-    Model(Dataset &d, size_t start_norm) {
-        y_label = new model_arr(d.get_labels());
+    Model(Dataset &d, size_t start_norm, Communicator *communicator = nullptr) {
+        comm = communicator;
+        if(!shards_nonempty(d)) {
+            good = false;
+            return;
+        }
+        pool = std::make_unique<ML::MemoryPool>();
+        ML::MemoryPool::Scope scope(pool.get());
+        y_label = train_arr(d.get_labels());
 
         // Create feature vector with bias column (first column)
-        feat_bias = new model_arr(ML::generate_feat_bias(d.get_features()));
-
-        // Store feature matrix shape and normalize
-        fb_shape = std::make_tuple(feat_bias->shape().at(0), feat_bias->shape().at(1));
-        for(size_t c = start_norm + 1; c < std::get<1>(fb_shape); c += 1) {
-            feat_norms.insert({ c, ZScaleNormalizer(
-                xt::mean(xt::col(*feat_bias, c))(),
-                xt::stddev(xt::col(*feat_bias, c))()
-            )});
+        feat_bias = ML::generate_feat_bias<train_arr>(d.get_features());
+
+        // Normalize features
+        size_t rows = feat_bias.shape().at(0), cols = feat_bias.shape().at(1);
+        n_samples = comm ? (size_t)comm->allreduce_sum((double)rows) : rows;
+        for(size_t c = 0; c < cols; c += 1)
+            feat_stats.push_back(ML::column_normalizer(xt::col(feat_bias, c), comm));
+        for(size_t c = start_norm + 1; c < cols; c += 1) {
+            feat_norms.insert({ c, feat_stats.at(c) });
             ZScaleNormalizer c_norm = feat_norms.at(c);
-            xt::col(*feat_bias, c) = (xt::col(*feat_bias, c) - c_norm.mean) / c_norm.std;
+            xt::col(feat_bias, c) = (xt::col(feat_bias, c) - c_norm.mean) / c_norm.std;
         }
 
         // Initialize weights
-        weights = xt::zeros<double>({ std::get<1>(fb_shape), (size_t)1 });
+        weights = xt::zeros<double>({ cols, (size_t)1 });
+        fold_weights();
     }
 
     /**
@@ -152,50 +273,149 @@ protected:
      * Also normalizes labels, adds bias column to feature matrix, initializes weights, stores label normalization information.
      * The first `start_norm - 1` columns of the Dataset feature matrix will not be normalized.
      * 
+     * With a Communicator, `d` is this rank's shard and normalization uses statistics over all ranks.
+     * isGood() is false if any rank has an empty shard.
+     * 
      * @param d Dataset object.
      * @param norm_lab bool: determines whether labels will be normalized.
      * @param start_norm size_t: column index from which normalization will be applied.
+     * @param communicator Communicator for distributed training, nullptr for single process.
      */
-    Model(Dataset &d, bool norm_lab, size_t start_norm) {
+    Model(Dataset &d, bool norm_lab, size_t start_norm, Communicator *communicator = nullptr) {
+        comm = communicator;
+        if(!shards_nonempty(d)) {
+            good = false;
+            return;
+        }
+        pool = std::make_unique<ML::MemoryPool>();
+        ML::MemoryPool::Scope scope(pool.get());
+
         // Get labels and normalize if needed
         normalizeLabels = norm_lab;
-        y_label = new model_arr(d.get_labels());
+        y_label = train_arr(d.get_labels());
         if(normalizeLabels) {
-            y_norm.mean = xt::mean(*y_label)();
-            y_norm.std = xt::stddev(*y_label)();
-            *y_label = (*y_label - y_norm.mean) / y_norm.std;
+            y_norm = ML::column_normalizer(y_label, comm);
+            y_label = (y_label - y_norm.mean) / y_norm.std;
         }
 
         // Create feature vector with bias column (first column)
-        feat_bias = new model_arr(ML::generate_feat_bias(d.get_features()));
-
-        // Store feature matrix shape and normalize
-        fb_shape = std::make_tuple(feat_bias->shape().at(0), feat_bias->shape().at(1));
-        for(size_t c = start_norm + 1; c < std::get<1>(fb_shape); c += 1) {
-            feat_norms.insert({ c, ZScaleNormalizer(
-                xt::mean(xt::col(*feat_bias, c))(),
-                xt::stddev(xt::col(*feat_bias, c))()
-            )});
+        feat_bias = ML::generate_feat_bias<train_arr>(d.get_features());
+
+        // Normalize features
+        size_t rows = feat_bias.shape().at(0), cols = feat_bias.shape().at(1);
+        n_samples = comm ? (size_t)comm->allreduce_sum((double)rows) : rows;
+        for(size_t c = 0; c < cols; c += 1)
+            feat_stats.push_back(ML::column_normalizer(xt::col(feat_bias, c), comm));
+        for(size_t c = start_norm + 1; c < cols; c += 1) {
+            feat_norms.insert({ c, feat_stats.at(c) });
             ZScaleNormalizer c_norm = feat_norms.at(c);
-            xt::col(*feat_bias, c) = (xt::col(*feat_bias, c) - c_norm.mean) / c_norm.std;
+            xt::col(feat_bias, c) = (xt::col(feat_bias, c) - c_norm.mean) / c_norm.std;
         }
         
         // Initialize weights
-        weights = xt::zeros<double>({ (size_t)std::get<1>(fb_shape), (size_t)1 });
+        weights = xt::zeros<double>({ cols, (size_t)1 });
+        fold_weights();
     }
 
-    inline void delete_feat_bias() {
-        delete feat_bias;
-        feat_bias = nullptr;
+    /**
+     * @brief Checks that every rank has training rows.
+     * 
+     * Collective: must be called by all ranks before any other reduction.
+     * An empty shard (world size larger than the row count) would make every global mean NaN.
+     * 
+     * @param d This rank's Dataset shard.
+     * @return Whether no rank has an empty shard.
+     */
+    inline bool shards_nonempty(Dataset &d) const {
+        double empty = d.get_labels().shape().at(0) == 0 ? 1.0 : 0.0;
+        if(comm != nullptr)
+            empty = comm->allreduce_sum(empty);
+        if(empty > 0.0) {
+            std::cerr << "Cannot train! " << empty << " rank(s) have no training rows, use fewer ranks than rows!\n";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks that the model still holds its training data.
+     * 
+     * @return False for models loaded from a file or already trained.
+     */
+    inline bool has_training_data() const {
+        if(feat_bias.size() == 0 || y_label.size() == 0) {
+            std::cerr << "Cannot train! Model has no training data (loaded from file or already trained)!\n";
+            return false;
+        }
+        return true;
+    }
+
+    inline void delete_feat_bias() { feat_bias = train_arr(); }
+    inline void delete_y_label() { y_label = train_arr(); }
+
+    /**
+     * @brief Averages a per-row mean over all ranks.
+     * 
+     * @param local_mean Mean over this rank's rows.
+     * @return Mean over all training rows.
+     */
+    inline double global_mean(double local_mean) const {
+        if(comm == nullptr)
+            return local_mean;
+        return comm->allreduce_sum(local_mean * feat_bias.shape().at(0)) / n_samples;
+    }
+
+    /**
+     * @brief Forward pass into a preallocated buffer: y = feat_bias * weights (gemv).
+     * 
+     * @param y Output (n, 1).
+     */
+    inline void forward(train_arr &y) const {
+        auto w_vec = ML::column_vector(weights);
+        auto y_vec = ML::column_vector(y);
+        xt::blas::gemv(feat_bias, w_vec, y_vec);
+    }
+
+    /**
+     * @brief Gradient into a preallocated buffer: grad = scale * feat_bias^T * r (transposed gemv).
+     * 
+     * @param r Per-row residual (n, 1).
+     * @param scale Factor applied to the product.
+     * @param grad Output (d + 1, 1).
+     */
+    inline void backward(const train_arr &r, double scale, train_arr &grad) const {
+        auto r_vec = ML::column_vector(r);
+        auto grad_vec = ML::column_vector(grad);
+        xt::blas::gemv(feat_bias, r_vec, grad_vec, true);
+        grad *= scale;
     }
-    inline void delete_y_label() {
-        delete y_label;
-        y_label = nullptr;
+
+    /**
+     * @brief Sums a gradient over all ranks in place.
+     * 
+     * @param grad Local gradient (already scaled by 1 / n_samples).
+     */
+    inline void allreduce_grad(train_arr &grad) const {
+        if(comm != nullptr)
+            comm->allreduce_sum(grad.data(), grad.size());
     }
 
-    inline model_arr & getLabels() { return *y_label; }
-    inline model_arr & getFeatures() { return *feat_bias; }
+    void fold_weights();
+
+    bool write(const std::string &, const std::string &) const;
+    bool read(const std::string &, const std::string &);
+
+public:
+    inline bool isRoot() const { return comm == nullptr || comm->isRoot(); }
+    inline bool isGood() const { return good; }
+
+    static std::string file_kind(const std::string &);
+    std::vector<double> raw_weights() const;
+
+protected:
+    inline train_arr & getLabels() { return y_label; }
+    inline train_arr & getFeatures() { return feat_bias; }
     inline model_arr & getWeights() { return weights; }
-    inline std::tuple<size_t, size_t> getShape() const { return fb_shape; }
-    inline int getNumFeatures() const { return std::get<1>(fb_shape) - 1; }
+    inline std::array<size_t, 2> getShape() const { return feat_bias.shape(); }
+    inline int getNumFeatures() const { return weights.shape().at(0) - 1; }
 };
\ No newline at end of file
@@ -1,19 +1,19 @@
 #pragma once
 #include "Model.hpp"
+#include "QuantizedClassifier.hpp"
 #include "utils/Dataset.hpp"
-#include "xtensor/containers/xarray.hpp"
+#include "xtensor/containers/xtensor.hpp"
 
 class SupportVectorMachine : public Model {
 public:
-    SupportVectorMachine(Dataset &, size_t);
+    SupportVectorMachine(Dataset &, size_t, Communicator * = nullptr);
+    explicit SupportVectorMachine(const std::string &);
 
-    ~SupportVectorMachine() {
-        delete_feat_bias();
-        delete_y_label();
-    }
-
-    static double Hinge(const model_arr &, const model_arr &);
+    template<typename A>
+    static double Hinge(const A &, const A &);
     void train(size_t, double);
-    model_arr output(model_arr);
-    model_arr operator()(model_arr);
+    bool save(const std::string &) const;
+    model_arr output(const model_arr &) const;
+    QuantizedClassifier quantize() const;
+    model_arr operator()(const model_arr &) const;
 };
\ No newline at end of file
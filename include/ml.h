@@ -0,0 +1,90 @@
+#ifndef ML_H
+#define ML_H
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * C API for batch inference with models saved by the linear_regression, perceptron
+ * and support_vector_machine tools (--save-model).
+ *
+ * A loaded model is immutable: ml_predict_batch* only read it, so one model can be
+ * shared by any number of threads without locking.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ml_model ml_model;
+
+enum {
+    ML_OK = 0,
+    ML_ERR_ARG = -1,        /* NULL model or buffer */
+    ML_ERR_SHAPE = -2,      /* n_cols does not match the model */
+    ML_ERR_INTERNAL = -3,   /* Unexpected internal error (e.g. out of memory) */
+    ML_ERR_KIND = -4        /* Not supported by this model type (int8 scoring of a regression model) */
+};
+
+/**
+ * @brief Loads a model file.
+ *
+ * @param path Model file path.
+ * @return Model handle, NULL on failure. Free with ml_model_free.
+ */
+ml_model *ml_model_load(const char *path);
+void ml_model_free(ml_model *model);
+
+/**
+ * @brief Number of input features (columns) the model expects.
+ */
+size_t ml_model_num_features(const ml_model *model);
+
+/**
+ * @brief Scores a batch of rows.
+ *
+ * Rows are raw features (no bias column, not normalized) in row-major order.
+ * Regression writes the predicted value, classifiers write -1 or 1.
+ *
+ * @param model Loaded model.
+ * @param x Input matrix (n_rows, n_cols).
+ * @param n_rows Number of rows.
+ * @param n_cols Number of columns, must equal ml_model_num_features.
+ * @param out Output buffer with n_rows elements.
+ * @return ML_OK or an ML_ERR_* code.
+ */
+int ml_predict_batch(const ml_model *model, const double *x, size_t n_rows, size_t n_cols, double *out);
+int ml_predict_batch_f32(const ml_model *model, const float *x, size_t n_rows, size_t n_cols, float *out);
+
+/**
+ * @brief Quantizes a batch of rows to int8 for ml_predict_batch_i8 (classifiers only).
+ *
+ * Quantize rows once and keep them as int8 to stream them through scoring with 8x less memory traffic.
+ * Int8 classes can differ from ml_predict_batch for rows close to the decision boundary.
+ *
+ * @param model Loaded classifier.
+ * @param x Input matrix (n_rows, n_cols), same layout as ml_predict_batch.
+ * @param n_rows Number of rows.
+ * @param n_cols Number of columns, must equal ml_model_num_features.
+ * @param out Quantized matrix (n_rows, n_cols).
+ * @return ML_OK or an ML_ERR_* code.
+ */
+int ml_quantize_batch(const ml_model *model, const double *x, size_t n_rows, size_t n_cols, int8_t *out);
+int ml_quantize_batch_f32(const ml_model *model, const float *x, size_t n_rows, size_t n_cols, int8_t *out);
+
+/**
+ * @brief Classifies a batch of int8 rows from ml_quantize_batch (classifiers only).
+ *
+ * @param model Loaded classifier.
+ * @param q Quantized matrix (n_rows, n_cols).
+ * @param n_rows Number of rows.
+ * @param n_cols Number of columns, must equal ml_model_num_features.
+ * @param out Output buffer with n_rows classes (-1 or 1).
+ * @return ML_OK or an ML_ERR_* code.
+ */
+int ml_predict_batch_i8(const ml_model *model, const int8_t *q, size_t n_rows, size_t n_cols, int8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Collective communication between training processes.
+ *
+ * Ranks are arranged in a ring: every rank sends to rank + 1 and receives from rank - 1.
+ * Transports only implement the point-to-point ring exchange.
+ * allreduce_sum is built on top of it as a ring reduce-scatter followed by a ring allgather.
+ */
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    virtual size_t rank() const = 0;
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Send `send_buf` to the next rank while receiving `recv_buf` from the previous rank.
+     *
+     * Both transfers must progress together, otherwise large exchanges deadlock around the ring.
+     *
+     * @param send_buf Buffer sent to rank + 1.
+     * @param send_bytes Number of bytes to send.
+     * @param recv_buf Buffer filled by rank - 1.
+     * @param recv_bytes Number of bytes to receive.
+     * @throws std::runtime_error If the exchange fails or times out; collectives built on it propagate the exception.
+     */
+    virtual void ring_exchange(const void *send_buf, size_t send_bytes, void *recv_buf, size_t recv_bytes) = 0;
+
+    void allreduce_sum(double *data, size_t n);
+
+    /**
+     * @brief Sum a single value over all ranks.
+     *
+     * @param v Local value.
+     * @return Sum of v over all ranks.
+     */
+    inline double allreduce_sum(double v) {
+        allreduce_sum(&v, 1);
+        return v;
+    }
+
+    inline bool isRoot() const { return rank() == 0; }
+};
+
+/**
+ * @brief Communicator over stream sockets.
+ *
+ * Address is "tcp:<host>:<base port>" or "unix:<path prefix>" for ranks on one host,
+ * or "tcp:<host 0>:<port 0>,<host 1>:<port 1>,..." / "hostfile:<path>" with one endpoint per rank
+ * for ranks spread over several machines.
+ * Every process must be launched with the same address and world size.
+ *
+ * Setup and every exchange give up after `timeout` seconds without progress (a rank that never starts
+ * or stops responding), so it must exceed the longest computation between two collectives.
+ */
+class SocketCommunicator : public Communicator {
+private:
+    bool good;
+    size_t r;
+    size_t world;
+    int timeout_ms;
+    int listen_fd = -1;
+    int next_fd = -1;
+    int prev_fd = -1;
+    std::string unix_path;
+public:
+    SocketCommunicator(const std::string &, size_t, size_t, double = 60.0);
+    SocketCommunicator(const SocketCommunicator &) = delete;
+    SocketCommunicator & operator=(const SocketCommunicator &) = delete;
+    ~SocketCommunicator();
+
+    inline size_t rank() const override { return r; }
+    inline size_t size() const override { return world; }
+    inline bool isGood() const { return good; }
+
+    void ring_exchange(const void *, size_t, void *, size_t) override;
+};
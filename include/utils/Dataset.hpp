@@ -1,9 +1,9 @@
 #pragma once
 #include <fstream>
 #include <string>
-#include "xtensor/containers/xarray.hpp"
+#include "xtensor/containers/xtensor.hpp"
 
-typedef xt::xarray<double> data_array;
+typedef xt::xtensor<double, 2> data_array;
 
 class Dataset {
 private:
@@ -13,6 +13,7 @@ private:
 public:
     Dataset(std::string);
     Dataset(std::string, bool);
+    Dataset(std::string, bool, size_t, size_t);
     Dataset(const Dataset &) = default;
 
     inline data_array & get_features() { return features; }
@@ -16,6 +16,9 @@ public:
      * No header option if CSV files do not have header line.
      * Can specify epochs and learning rate.
      * Default epochs, learning rate are 20, 1e-3 respectively.
+     * Distributed training is enabled with world-size > 1; every rank is launched with its own rank
+     * and the same dist-addr: "tcp:<host>:<base port>" or "unix:<path prefix>" on one machine,
+     * "tcp:<host 0>:<port 0>,<host 1>:<port 1>,..." or "hostfile:<path>" across machines.
      * 
      * @return void
      */
@@ -27,6 +30,13 @@ public:
             ("no-header,N", po::value<bool>()->default_value(false), "Flag if CSV file has no header")
             ("epochs,e", po::value<size_t>()->default_value(20), "Number of epochs for training")
             ("lr", po::value<double>()->default_value(1e-3), "Learning rate for training")
+            ("hugepages", po::value<bool>()->default_value(false), "Back training memory with transparent hugepages")
+            ("save-model,S", po::value<std::string>()->default_value(""), "Write trained model to file")
+            ("quantize,Q", po::value<bool>()->default_value(false), "Also validate int8 quantized classifier")
+            ("rank", po::value<size_t>()->default_value(0), "Rank of this process for distributed training")
+            ("world-size", po::value<size_t>()->default_value(1), "Number of processes for distributed training")
+            ("dist-addr", po::value<std::string>()->default_value("tcp:127.0.0.1:29500"), "Rendezvous address for distributed training")
+            ("dist-timeout", po::value<double>()->default_value(60.0), "Seconds to wait for other ranks before giving up")
         ;
         
         p.add("input-file", 1);
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ML {
+
+/**
+ * @brief Arena backed pool for tensor storage.
+ *
+ * Memory is carved out of large chunks (optionally transparent hugepages) with a bump pointer.
+ * Freed blocks go to a free list per size class and are handed out again for the next allocation
+ * of the same size, so a training loop allocating the same temporaries every epoch stops touching
+ * the system allocator (and faulting in new pages) after the first epoch.
+ * Every block is 64-byte aligned.
+ *
+ * Each block starts with a header recording its owner, so memory can be freed through any
+ * PoolAllocator regardless of which pool (or the heap) it came from.
+ * A pool must outlive every block allocated from it and must only be used from one thread at a time.
+ */
+class MemoryPool {
+private:
+    struct Chunk {
+        char *base;
+        size_t bytes;
+        size_t used;
+        size_t live;        // Blocks currently handed out
+        bool mapped;        // mmap'ed (hugepages) instead of operator new
+    };
+    struct alignas(64) Header {
+        MemoryPool *owner;
+        Chunk *chunk;
+        size_t size_class;  // Block size including header
+    };
+
+    size_t chunk_bytes;
+    bool hugepages;
+    size_t reserved_bytes = 0;
+    std::list<Chunk> chunks;
+    Chunk *active = nullptr;
+    std::unordered_map<size_t, std::vector<Header *>> free_blocks;
+
+    static bool default_hugepages;
+    static thread_local MemoryPool *current_pool;
+
+    Chunk & new_chunk(size_t);
+    void free_chunk(Chunk &);
+    void release(Header *);
+public:
+    static constexpr size_t alignment = 64;
+
+    MemoryPool(size_t = (size_t)1 << 21, bool = default_hugepages);
+    MemoryPool(const MemoryPool &) = delete;
+    MemoryPool & operator=(const MemoryPool &) = delete;
+    ~MemoryPool();
+
+    void *allocate(size_t);
+    void trim();
+    inline size_t reserved() const { return reserved_bytes; }
+
+    static void *heap_allocate(size_t);
+    static void deallocate(void *);
+
+    static inline MemoryPool *current() { return current_pool; }
+    static inline void set_default_hugepages(bool h) { default_hugepages = h; }
+
+    /**
+     * @brief Routes PoolAllocator allocations on this thread to a pool while in scope.
+     *
+     * Scopes nest; nullptr routes allocations to the (64-byte aligned) heap.
+     */
+    class Scope {
+    private:
+        MemoryPool *prev;
+    public:
+        explicit Scope(MemoryPool *pool) : prev(current_pool) { current_pool = pool; }
+        Scope(const Scope &) = delete;
+        Scope & operator=(const Scope &) = delete;
+        ~Scope() { current_pool = prev; }
+    };
+};
+
+/**
+ * @brief Allocator for xtensor containers backed by MemoryPool.
+ *
+ * A default constructed allocator (which is what xtensor uses for containers and expression temporaries)
+ * allocates from MemoryPool::current(), or from the heap when no Scope is active.
+ * Copies of a container follow the scope active at the time of the copy, not the pool of the original.
+ */
+template<typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::true_type is_always_equal;
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    template<typename U>
+    struct rebind { typedef PoolAllocator<U> other; };
+
+    MemoryPool *pool;
+
+    PoolAllocator() noexcept : pool(MemoryPool::current()) {}
+    explicit PoolAllocator(MemoryPool *p) noexcept : pool(p) {}
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U> &other) noexcept : pool(other.pool) {}
+
+    inline T *allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        return static_cast<T *>(pool ? pool->allocate(bytes) : MemoryPool::heap_allocate(bytes));
+    }
+    inline void deallocate(T *p, size_t) noexcept { MemoryPool::deallocate(p); }
+
+    inline PoolAllocator select_on_container_copy_construction() const { return PoolAllocator(); }
+};
+
+template<typename T, typename U>
+inline bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) { return true; }
+template<typename T, typename U>
+inline bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) { return false; }
+
+}
@@ -1,8 +1,11 @@
 #include "utils/Dataset.hpp"
 #include "LinearRegression.hpp"
 #include "utils/ML_CLIOptions.hpp"
+#include "utils/Communicator.hpp"
 #include <iostream>
-#include "xtensor/containers/xarray.hpp"
+#include <memory>
+#include <stdexcept>
+#include "xtensor/containers/xtensor.hpp"
 #include "xtensor/views/xview.hpp"
 #include "xtensor/generators/xbuilder.hpp"
 
@@ -19,27 +22,55 @@ int main(int argc, char **argv) {
     
     bool no_header = cli.vm["no-header"].as<bool>();
     std::string input = cli.vm["input-file"].as<std::string>();
+    size_t rank = cli.vm["rank"].as<size_t>();
+    size_t world_size = cli.vm["world-size"].as<size_t>();
 
-    // Load dataset
-    Dataset data(input, no_header);
+    // Connect to other ranks
+    std::unique_ptr<SocketCommunicator> comm;
+    if(world_size > 1) {
+        comm = std::make_unique<SocketCommunicator>(cli.vm["dist-addr"].as<std::string>(), rank, world_size,
+                                                    cli.vm["dist-timeout"].as<double>());
+        if(!comm->isGood()) {
+            std::cerr << "Could not connect to other ranks!\n";
+            return -1;
+        }
+    }
+
+    // Load dataset (this rank's shard)
+    Dataset data(input, no_header, rank, world_size);
     if(!data.isGood()) {
         std::cerr << "Could not read input CSV!\n";
         return -1;
     }
     
     // Create regression
-    LinearRegression lin_reg(data, true, 2);
+    ML::MemoryPool::set_default_hugepages(cli.vm["hugepages"].as<bool>());
+    try {
+        LinearRegression lin_reg(data, true, 2, comm.get());
+        if(!lin_reg.isGood())
+            return -1;
 
-    // Train
-    size_t epochs = cli.vm["epochs"].as<size_t>();
-    double lr = cli.vm["lr"].as<double>();
-    std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
-    lin_reg.train(epochs, lr);
+        // Train
+        size_t epochs = cli.vm["epochs"].as<size_t>();
+        double lr = cli.vm["lr"].as<double>();
+        if(lin_reg.isRoot())
+            std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
+        lin_reg.train(epochs, lr);
 
-    // Validation
-    if(cli.vm.count("test-file")) {
-        std::string val_file = cli.vm["test-file"].as<std::string>();
-        validation(lin_reg, val_file, no_header);
+        // Save model
+        std::string model_file = cli.vm["save-model"].as<std::string>();
+        if(lin_reg.isRoot() && !model_file.empty() && !lin_reg.save(model_file))
+            std::cerr << "Could not save model!\n";
+
+        // Validation
+        if(lin_reg.isRoot() && cli.vm.count("test-file")) {
+            std::string val_file = cli.vm["test-file"].as<std::string>();
+            validation(lin_reg, val_file, no_header);
+        }
+    } catch(const std::exception &e) {
+        // Lost a neighbouring rank during training
+        std::cerr << e.what() << "\n";
+        return -1;
     }
 
     return 0;
@@ -52,12 +83,12 @@ void validation(LinearRegression &lin_reg, std::string val_file, bool no_header)
         return;
     }
 
-    xt::xarray<double> f1 = ML::generate_feat_bias(val_data.get_features());
-    xt::xarray<double> f2 = ML::generate_feat_bias(val_data.get_features());
-    xt::xarray<double> res_norm = lin_reg(f1);                                                                  // Model output (raw)    
-    xt::xarray<double> labels_norm = (val_data.get_labels() - lin_reg.getYMean()) / lin_reg.getYSTD();          // Labels (normalized)
-    xt::xarray<double> res = lin_reg.output_raw(f2);                                                            // Model output (normalized)
-    xt::xarray<double> labels = val_data.get_labels();                                                          // Labels (raw)
+    model_arr f1 = ML::generate_feat_bias(val_data.get_features());
+    model_arr f2 = ML::generate_feat_bias(val_data.get_features());
+    model_arr res_norm = lin_reg(f1);                                                                  // Model output (raw)    
+    model_arr labels_norm = (val_data.get_labels() - lin_reg.getYMean()) / lin_reg.getYSTD();          // Labels (normalized)
+    model_arr res = lin_reg.output_raw(f2);                                                            // Model output (normalized)
+    model_arr labels = val_data.get_labels();                                                          // Labels (raw)
     std::cout << "MSE Loss (normalized): " << LinearRegression::MSE(labels_norm, res_norm) << std::endl
               << "MSE Loss (raw):        " << LinearRegression::MSE(labels, res) << std::endl
               << "R^2 (normalized):      " << ML::R_Squared(labels_norm, res_norm) << std::endl
@@ -1,7 +1,10 @@
 #include "Perceptron.hpp"
 #include "utils/ML_CLIOptions.hpp"
+#include "utils/Communicator.hpp"
+#include <memory>
+#include <stdexcept>
 
-void validation(Perceptron &, std::string, bool);
+void validation(Perceptron &, std::string, bool, bool);
 
 int main(int argc, char **argv) {
     ML_CLIOptions cli;
@@ -9,33 +12,69 @@ int main(int argc, char **argv) {
 
     std::string input_file = cli.vm["input-file"].as<std::string>();
     bool no_header = cli.vm["no-header"].as<bool>();
+    size_t rank = cli.vm["rank"].as<size_t>();
+    size_t world_size = cli.vm["world-size"].as<size_t>();
 
-    // Load dataset
-    Dataset data(input_file, no_header);
+    // Connect to other ranks
+    std::unique_ptr<SocketCommunicator> comm;
+    if(world_size > 1) {
+        comm = std::make_unique<SocketCommunicator>(cli.vm["dist-addr"].as<std::string>(), rank, world_size,
+                                                    cli.vm["dist-timeout"].as<double>());
+        if(!comm->isGood()) {
+            std::cerr << "Could not connect to other ranks!\n";
+            return -1;
+        }
+    }
+
+    // Load dataset (this rank's shard)
+    Dataset data(input_file, no_header, rank, world_size);
     if(!data.isGood()) {
         std::cerr << "Could not load training dataset!\n";
         return -1;
     }
 
-    Perceptron p(data, 28);
+    ML::MemoryPool::set_default_hugepages(cli.vm["hugepages"].as<bool>());
+    try {
+        Perceptron p(data, 28, comm.get());
+        if(!p.isGood())
+            return -1;
+
+        // Train
+        size_t epochs = cli.vm["epochs"].as<size_t>();
+        double lr = cli.vm["lr"].as<double>();
+        if(p.isRoot())
+            std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
+        p.train(epochs, lr);
 
-    // Train
-    size_t epochs = cli.vm["epochs"].as<size_t>();
-    double lr = cli.vm["lr"].as<double>();
-    std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
-    p.train(epochs, lr);
+        // Save model
+        std::string model_file = cli.vm["save-model"].as<std::string>();
+        if(p.isRoot() && !model_file.empty() && !p.save(model_file))
+            std::cerr << "Could not save model!\n";
 
-    if(cli.vm.count("test-file")) {
-        validation(p, cli.vm["test-file"].as<std::string>(), no_header);
+        if(p.isRoot() && cli.vm.count("test-file")) {
+            validation(p, cli.vm["test-file"].as<std::string>(), no_header, cli.vm["quantize"].as<bool>());
+        }
+    } catch(const std::exception &e) {
+        // Lost a neighbouring rank during training
+        std::cerr << e.what() << "\n";
+        return -1;
     }
 
     return 0;
 }
 
-void validation(Perceptron &p, std::string test_file, bool no_header) {
+void validation(Perceptron &p, std::string test_file, bool no_header, bool quantize) {
     Dataset val(test_file, no_header);
-    xt::xarray<double> y_labels = val.get_labels();
-    xt::xarray<double> input_feat = ML::generate_feat_bias(val.get_features());
-    xt::xarray<double> y = p(input_feat);
+    model_arr y_labels = val.get_labels();
+    model_arr input_feat = ML::generate_feat_bias(val.get_features());
+    model_arr y = p(input_feat);
     std::cout << ML::accuracy(y_labels, y) << std::endl;
+
+    if(quantize) {
+        QuantizedClassifier q = p.quantize();
+        model_arr y_q = q(input_feat);
+        QuantizationReport r = QuantizedClassifier::sign_agreement(y, y_q);
+        std::cout << "Quantized accuracy: " << ML::accuracy(y_labels, y_q) << std::endl
+                  << "Sign agreement    : " << r.agreement << " (" << r.disagree << "/" << r.rows << " rows differ)" << std::endl;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "utils/Communicator.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Sums `data` element-wise over all ranks in place.
+ *
+ * Ring allreduce: `data` is split into one segment per rank.
+ * A reduce-scatter pass leaves every rank with one fully summed segment,
+ * then an allgather pass circulates the summed segments.
+ * Every rank ends with bitwise identical results.
+ *
+ * @param data Local values, overwritten with the global sum.
+ * @param n Number of elements in data.
+ */
+void Communicator::allreduce_sum(double *data, size_t n) {
+    size_t p = size();
+    if(p <= 1 || n == 0)
+        return;
+
+    // Segment boundaries (first n % p segments get one extra element)
+    std::vector<size_t> offset(p + 1, 0);
+    for(size_t s = 0; s < p; s += 1)
+        offset[s + 1] = offset[s] + n / p + (s < n % p ? 1 : 0);
+    auto seg_len = [&](size_t s) { return offset[s + 1] - offset[s]; };
+
+    size_t me = rank();
+    std::vector<double> recv_buf(n / p + 1);
+
+    // Reduce-scatter
+    for(size_t step = 0; step < p - 1; step += 1) {
+        size_t send_seg = (me + p - step) % p;
+        size_t recv_seg = (me + p - step - 1) % p;
+        ring_exchange(data + offset[send_seg], seg_len(send_seg) * sizeof(double),
+                      recv_buf.data(), seg_len(recv_seg) * sizeof(double));
+        for(size_t i = 0; i < seg_len(recv_seg); i += 1)
+            data[offset[recv_seg] + i] += recv_buf[i];
+    }
+
+    // Allgather
+    for(size_t step = 0; step < p - 1; step += 1) {
+        size_t send_seg = (me + p + 1 - step) % p;
+        size_t recv_seg = (me + p - step) % p;
+        ring_exchange(data + offset[send_seg], seg_len(send_seg) * sizeof(double),
+                      data + offset[recv_seg], seg_len(recv_seg) * sizeof(double));
+    }
+}
+
+/**
+ * @brief Resolves IPv4 TCP address.
+ *
+ * @param host Host name or address.
+ * @param port TCP port.
+ * @param out Resolved address.
+ * @return Whether host could be resolved.
+ */
+static bool resolve_tcp(const std::string &host, int port, sockaddr_storage &out) {
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+        std::cerr << "Could not resolve host " << host << "!\n";
+        return false;
+    }
+    std::memcpy(&out, res->ai_addr, sizeof(sockaddr_in));
+    freeaddrinfo(res);
+    reinterpret_cast<sockaddr_in *>(&out)->sin_port = htons(port);
+    return true;
+}
+
+/**
+ * @brief Splits "<host>:<port>" endpoint.
+ *
+ * @return Whether endpoint has a host and a valid port.
+ */
+static bool split_endpoint(const std::string &endpoint, std::string &host, int &port) {
+    size_t colon = endpoint.rfind(':');
+    if(colon == std::string::npos || colon == 0)
+        return false;
+    host = endpoint.substr(0, colon);
+    port = std::atoi(endpoint.substr(colon + 1).c_str());
+    return port > 0 && port < 65536;
+}
+
+/**
+ * @brief Opens listening socket and connects ring neighbours.
+ *
+ * Each rank listens on its own address, connects to rank + 1 (retrying until it is up)
+ * and accepts the connection from rank - 1.
+ * Check isGood() before using the communicator.
+ *
+ * Addresses:
+ * - "tcp:<host>:<base port>": all ranks on one host, rank r listens on <host>:<base port> + r.
+ * - "tcp:<host 0>:<port 0>,<host 1>:<port 1>,...": one endpoint per rank, ranks may run on different machines.
+ * - "hostfile:<path>": same as the list form, one "<host>:<port>" per line (blank lines and # comments ignored).
+ * - "unix:<path prefix>": all ranks on one host, rank r listens on <path prefix>.r.
+ * With an endpoint list, each rank listens on all interfaces at its own port.
+ *
+ * @param addr Rendezvous address.
+ * @param rank Rank of this process in [0, world_size).
+ * @param world_size Number of processes.
+ * @param timeout Seconds to wait for the neighbouring ranks during setup and each exchange.
+ */
+SocketCommunicator::SocketCommunicator(const std::string &addr, size_t rank, size_t world_size, double timeout) {
+    good = true;
+    r = rank;
+    world = world_size;
+    timeout_ms = (int)(timeout * 1000.0);
+    if(world <= 1)
+        return;
+    if(r >= world) {
+        std::cerr << "Rank " << r << " out of range for world size " << world << "!\n";
+        good = false;
+        return;
+    }
+
+    size_t next = (r + 1) % world;
+    bool hostfile = addr.rfind("hostfile:", 0) == 0;
+    bool tcp = hostfile || addr.rfind("tcp:", 0) == 0;
+    bool unix_sock = addr.rfind("unix:", 0) == 0;
+    if(!tcp && !unix_sock) {
+        std::cerr << "Unknown transport in address " << addr << "!\n";
+        good = false;
+        return;
+    }
+
+    // Resolve own (listen) and next rank (connect) addresses
+    sockaddr_storage listen_addr{}, next_addr{};
+    socklen_t addr_len = 0;
+    int family = AF_UNIX;
+    if(tcp) {
+        // Collect endpoints (one per rank, or a single base endpoint)
+        std::vector<std::string> endpoints;
+        if(hostfile) {
+            std::ifstream f(addr.substr(9));
+            if(f.fail()) {
+                std::cerr << "Could not open hostfile " << addr.substr(9) << "!\n";
+                good = false;
+                return;
+            }
+            std::string line;
+            while(std::getline(f, line)) {
+                line = line.substr(0, line.find('#'));
+                line.erase(0, line.find_first_not_of(" \t\r"));
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if(!line.empty())
+                    endpoints.push_back(line);
+            }
+        } else {
+            std::stringstream list(addr.substr(4));
+            std::string endpoint;
+            while(std::getline(list, endpoint, ','))
+                endpoints.push_back(endpoint);
+        }
+
+        bool per_rank = hostfile || endpoints.size() > 1;
+        if(per_rank && endpoints.size() != world) {
+            std::cerr << "Expected " << world << " endpoints, got " << endpoints.size() << "!\n";
+            good = false;
+            return;
+        }
+
+        std::string own_host, next_host;
+        int own_port = 0, next_port = 0;
+        bool parsed = !endpoints.empty();
+        if(parsed && per_rank) {
+            parsed = split_endpoint(endpoints[r], own_host, own_port) && split_endpoint(endpoints[next], next_host, next_port);
+        } else if(parsed) {
+            parsed = split_endpoint(endpoints[0], own_host, own_port);
+            next_host = own_host;
+            next_port = own_port + next;
+            own_port += r;
+        }
+        if(!parsed || own_port >= 65536 || next_port >= 65536) {
+            std::cerr << "Bad TCP address " << addr << "!\n";
+            good = false;
+            return;
+        }
+
+        family = AF_INET;
+        addr_len = sizeof(sockaddr_in);
+        if(per_rank) {
+            auto *l = reinterpret_cast<sockaddr_in *>(&listen_addr);
+            l->sin_family = AF_INET;
+            l->sin_addr.s_addr = htonl(INADDR_ANY);
+            l->sin_port = htons(own_port);
+        } else if(!resolve_tcp(own_host, own_port, listen_addr)) {
+            good = false;
+            return;
+        }
+        if(!resolve_tcp(next_host, next_port, next_addr)) {
+            good = false;
+            return;
+        }
+    } else {
+        std::string prefix = addr.substr(5);
+        unix_path = prefix + "." + std::to_string(r);
+        std::string next_path = prefix + "." + std::to_string(next);
+        if(next_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            std::cerr << "Unix socket path too long: " << next_path << "\n";
+            good = false;
+            return;
+        }
+        addr_len = sizeof(sockaddr_un);
+        auto *l = reinterpret_cast<sockaddr_un *>(&listen_addr);
+        auto *n = reinterpret_cast<sockaddr_un *>(&next_addr);
+        l->sun_family = AF_UNIX;
+        n->sun_family = AF_UNIX;
+        std::strncpy(l->sun_path, unix_path.c_str(), sizeof(l->sun_path) - 1);
+        std::strncpy(n->sun_path, next_path.c_str(), sizeof(n->sun_path) - 1);
+        unlink(unix_path.c_str());
+    }
+
+    // Listen for previous rank
+    listen_fd = socket(family, SOCK_STREAM, 0);
+    int one = 1;
+    if(tcp)
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if(listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr *>(&listen_addr), addr_len) != 0
+       || listen(listen_fd, 1) != 0) {
+        std::cerr << "Could not listen on " << addr << " (rank " << r << "): " << std::strerror(errno) << "\n";
+        good = false;
+        return;
+    }
+
+    // Connect to next rank, which may not be up yet
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while(std::chrono::steady_clock::now() < deadline) {
+        next_fd = socket(family, SOCK_STREAM, 0);
+        if(connect(next_fd, reinterpret_cast<sockaddr *>(&next_addr), addr_len) == 0)
+            break;
+        close(next_fd);
+        next_fd = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if(next_fd < 0) {
+        std::cerr << "Could not connect to rank " << next << "!\n";
+        good = false;
+        return;
+    }
+
+    // Wait for previous rank, which may never start
+    size_t prev = (r + world - 1) % world;
+    pollfd pending = { listen_fd, POLLIN, 0 };
+    int ready;
+    do {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        ready = poll(&pending, 1, std::max(0, (int)left.count()));
+    } while(ready < 0 && errno == EINTR);
+    if(ready == 0) {
+        std::cerr << "Timed out waiting for rank " << prev << " to connect!\n";
+        good = false;
+        return;
+    }
+    prev_fd = ready > 0 ? accept(listen_fd, nullptr, nullptr) : -1;
+    if(prev_fd < 0) {
+        std::cerr << "Could not accept connection from previous rank: " << std::strerror(errno) << "\n";
+        good = false;
+        return;
+    }
+    if(tcp) {
+        setsockopt(next_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(prev_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+}
+
+SocketCommunicator::~SocketCommunicator() {
+    for(int fd : { next_fd, prev_fd, listen_fd })
+        if(fd >= 0)
+            close(fd);
+    if(!unix_path.empty())
+        unlink(unix_path.c_str());
+}
+
+/**
+ * @brief Sends to next rank and receives from previous rank concurrently.
+ *
+ * Uses poll so neither direction blocks the other.
+ * Socket errors throw, since the remaining ranks cannot make progress without this one.
+ * So does a neighbour that makes no progress for the timeout (hung without closing its socket).
+ *
+ * @throws std::runtime_error If poll fails, times out or the connection to a neighbouring rank is lost.
+ */
+void SocketCommunicator::ring_exchange(const void *send_buf, size_t send_bytes, void *recv_buf, size_t recv_bytes) {
+    const char *out = static_cast<const char *>(send_buf);
+    char *in = static_cast<char *>(recv_buf);
+    size_t sent = 0, received = 0;
+
+    while(sent < send_bytes || received < recv_bytes) {
+        pollfd fds[2];
+        nfds_t nfds = 0;
+        if(sent < send_bytes)
+            fds[nfds++] = { next_fd, POLLOUT, 0 };
+        if(received < recv_bytes)
+            fds[nfds++] = { prev_fd, POLLIN, 0 };
+        int ready = poll(fds, nfds, timeout_ms);
+        if(ready < 0) {
+            if(errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+        if(ready == 0)
+            throw std::runtime_error("Timed out waiting for neighbouring rank (rank " + std::to_string(r) + ")!");
+
+        for(nfds_t i = 0; i < nfds; i += 1) {
+            if(fds[i].revents == 0)
+                continue;
+            ssize_t k;
+            if(fds[i].fd == next_fd)
+                k = send(next_fd, out + sent, send_bytes - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            else
+                k = recv(prev_fd, in + received, recv_bytes - received, MSG_DONTWAIT);
+
+            if(k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                continue;
+            if(k <= 0) {
+                throw std::runtime_error("Lost connection to neighbouring rank (rank " + std::to_string(r) + ")!");
+            }
+            if(fds[i].fd == next_fd)
+                sent += k;
+            else
+                received += k;
+        }
+    }
+}
@@ -1,5 +1,8 @@
 #include "utils/Dataset.hpp"
+#include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <sstream>
 #include <string>
 #include "xtensor/io/xcsv.hpp"
 #include "xtensor/views/xview.hpp"
@@ -16,7 +19,21 @@
  * @param no_header Whether CSV has header or not. False by default.
 */
 Dataset::Dataset(std::string input) : Dataset(input, false) {}
-Dataset::Dataset(std::string input, bool no_header) {
+Dataset::Dataset(std::string input, bool no_header) : Dataset(input, no_header, 0, 1) {}
+
+/**
+ * @brief Creates one shard of a dataset for distributed training.
+ * 
+ * Same as Dataset(input, no_header) but only keeps rows `i` with `i % num_shards == shard`.
+ * Every rank of a distributed run loads its own shard of the same CSV.
+ * Other rows are skipped while reading lines, so memory use is that of the shard, not the whole file.
+ * 
+ * @param input CSV file path.
+ * @param no_header Whether CSV has header or not.
+ * @param shard Index of this shard (rank).
+ * @param num_shards Total number of shards (world size).
+*/
+Dataset::Dataset(std::string input, bool no_header, size_t shard, size_t num_shards) {
     good = true;
 
     // Load csv filestream
@@ -31,12 +48,35 @@ Dataset::Dataset(std::string input, bool no_header) {
     std::string csv_header;
     if(!no_header)
         std::getline(f, csv_header);
-    data_array csv = xt::load_csv<double>(f);
+    data_array csv;
+    if(num_shards > 1) {
+        // Keep this shard's lines before parsing, so a rank never holds the other shards' rows
+        std::stringstream shard_rows;
+        std::string line;
+        size_t cols = 0, row = 0;
+        while(std::getline(f, line)) {
+            if(line.empty() || line[0] == '#')
+                continue;
+            if(cols == 0)
+                cols = std::count(line.begin(), line.end(), ',') + 1;
+            if(row % num_shards == shard)
+                shard_rows << line << '\n';
+            row += 1;
+        }
+        csv = xt::load_csv<double>(shard_rows);
+        if(csv.shape().at(0) == 0)
+            csv = data_array::from_shape({ (size_t)0, cols });
+    } else {
+        csv = xt::load_csv<double>(f);
+    }
+    if(csv.shape().at(1) == 0) {
+        std::cerr << "CSV has no columns!\n";
+        good = false;
+        return;
+    }
 
-    // Extract last columns (labels)
-    labels = xt::col(csv, csv.shape().at(1) - 1);
-    if(labels.shape().size() == 1)
-        labels.reshape({ (size_t)labels.shape().at(0), (size_t)1 });
+    // Extract last columns (labels) as (n, 1)
+    labels = xt::view(csv, xt::all(), xt::range((size_t)csv.shape().at(1) - 1, (size_t)csv.shape().at(1)));
 
     // Extract data (features)
     features = xt::view(csv, xt::all(), xt::range((size_t)0, (size_t)csv.shape().at(1) - 1));
@@ -1,34 +1,46 @@
 #include "LinearRegression.hpp"
 #include "utils/Dataset.hpp"
 #include <limits>
-#include "xtensor/containers/xarray.hpp"
-#include "xtensor-blas/xlinalg.hpp"
+#include "xtensor/containers/xtensor.hpp"
+#include "xtensor/core/xnoalias.hpp"
 #include "xtensor/generators/xbuilder.hpp"
 
-LinearRegression::LinearRegression(Dataset &d, bool norm_lab, size_t start_norm) : Model(d, norm_lab, start_norm) {}
+LinearRegression::LinearRegression(Dataset &d, bool norm_lab, size_t start_norm, Communicator *comm) : Model(d, norm_lab, start_norm, comm) {}
 
 LinearRegression::LinearRegression(Dataset &d) : LinearRegression(d, false, 0) {}
 LinearRegression::LinearRegression(Dataset &d, bool norm_lab) : LinearRegression(d, norm_lab, 0) {}
 LinearRegression::LinearRegression(Dataset &d, size_t start_norm) : LinearRegression(d, false, start_norm) {}
 
+/**
+ * @brief Loads LinearRegression trained and saved with save().
+ * 
+ * Loaded model can only be used for inference. Check isGood() before use.
+ * 
+ * @param path Model file path.
+ */
+LinearRegression::LinearRegression(const std::string &path) {
+    good = read(path, "linear_regression");
+}
+
 /**
  * @brief Calculates MSE.
  * 
  * Takes model outputs and labels and calculates mean squared error.
  * 
- * @param y_lab xarray of expected/desired model output.
- * @param y xarray of model outputs.
+ * @param y_lab matrix of expected/desired model output.
+ * @param y matrix of model outputs.
  * @return MSE value (double).
  */
-double LinearRegression::MSE(const model_arr &y_lab, const model_arr &y) {
+template<typename A>
+double LinearRegression::MSE(const A &y_lab, const A &y) {
     // Make sure input shapes are the same
-    if(!ML::xarray_same_shape(y_lab, y)) {
+    if(!ML::same_shape(y_lab, y)) {
         std::cerr << "Cannot calculate loss! y_label and y_train have different dimensions!\n";
         return -1;
     }
 
     // MSE
-    model_arr sq_diff = xt::square(y_lab - y);
+    A sq_diff = xt::square(y_lab - y);
     double m = xt::mean(sq_diff)();
     return m;
 }
@@ -38,45 +50,79 @@ double LinearRegression::MSE(const model_arr &y_lab, const model_arr &y) {
  * 
  * Takes model outputs and labels and calculates sum squared error.
  * 
- * @param y_lab xarray of expected/desired model output.
- * @param y xarray of model outputs.
+ * @param y_lab matrix of expected/desired model output.
+ * @param y matrix of model outputs.
  * @return SSE value (double).
  */
-double LinearRegression::SSE(const model_arr &y_lab, const model_arr &y) {
+template<typename A>
+double LinearRegression::SSE(const A &y_lab, const A &y) {
     // Make sure input shapes are the same
-    if(!ML::xarray_same_shape(y_lab, y)) {
+    if(!ML::same_shape(y_lab, y)) {
         std::cerr << "Cannot calculate loss! y_label and y_train have different dimensions!\n";
         return -1;
     }
 
     // SSE
-    model_arr sq_diff = xt::square(y_lab - y);
+    A sq_diff = xt::square(y_lab - y);
     double s = xt::sum(sq_diff)();
     return s;
 }
 
+template double LinearRegression::MSE(const model_arr &, const model_arr &);
+template double LinearRegression::MSE(const train_arr &, const train_arr &);
+template double LinearRegression::SSE(const model_arr &, const model_arr &);
+template double LinearRegression::SSE(const train_arr &, const train_arr &);
+
 /**
  * @brief Trains LinearRegression using feat_bias features, y_label, and weights
  * 
  * Trains weights based on the feature and label matrices using the given epoch and learning rate values.
+ * When distributed, gradients and losses are summed over all ranks every epoch.
  * 
  * @param epochs Number of time dataset will be fed into model during training
  * @param lr Step size for updating weights.
  */
 void LinearRegression::train(size_t epochs, double lr) {
-    model_arr feat_bias_T = xt::transpose(*feat_bias);
-    for(size_t i = 0; i < epochs; i += 1) {
-        // forward pass
-        model_arr y_train = xt::linalg::dot(*feat_bias, weights);
-        double loss = MSE(*y_label, y_train);
-        std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
-
-        // Calculate gradient and update weights: (2 / N) * x * (f(x) - y)
-        model_arr grad = (2.0 / (double)std::get<0>(fb_shape)) * xt::linalg::dot(feat_bias_T, (y_train - *y_label));
-        weights -= lr * grad;
+    if(!has_training_data())
+        return;
+
+    // Epoch buffers go out of scope before trim(), so their chunks can be returned
+    {
+        ML::MemoryPool::Scope scope(pool.get());
+
+        // Buffers reused by every epoch
+        train_arr y_train = train_arr::from_shape(y_label.shape());
+        train_arr residual = train_arr::from_shape(y_label.shape());
+        train_arr grad = train_arr::from_shape(weights.shape());
+        for(size_t i = 0; i < epochs; i += 1) {
+            // forward pass
+            forward(y_train);
+            double loss = global_mean(MSE(y_label, y_train));
+            if(isRoot())
+                std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
+
+            // Calculate gradient and update weights: (2 / N) * x * (f(x) - y)
+            xt::noalias(residual) = y_train - y_label;
+            backward(residual, 2.0 / (double)n_samples, grad);
+            allreduce_grad(grad);
+            xt::noalias(weights) -= lr * grad;
+        }
     }
+    fold_weights();
     delete_feat_bias();
     delete_y_label();
+    if(pool)
+        pool->trim();
+}
+
+/**
+ * @brief Saves trained model for inference.
+ * 
+ * @param path Model file path.
+ * @return Whether the model was written.
+ */
+bool LinearRegression::save(const std::string &path) const {
+    return write(path, "linear_regression");
 }
 
 /**
@@ -88,7 +134,7 @@ void LinearRegression::train(size_t epochs, double lr) {
  * @param input_feat Feature matrix with bias column.
  * @return Model outputs without any normalization.
  */
-model_arr LinearRegression::output_raw(model_arr input_feat) {
+model_arr LinearRegression::output_raw(const model_arr &input_feat) const {
     model_arr y = (*this)(input_feat);
     if(normalizeLabels)
         y = (y * y_norm.std) + y_norm.mean;
@@ -99,19 +145,16 @@ model_arr LinearRegression::output_raw(model_arr input_feat) {
  * @brief Inference in a normalized space.
  * 
  * Output is normalized if labels were normalized during training.
+ * Feature normalizers are folded into the weights, so the input is scored as is.
  * 
- * @param input_feat Feature matrix with bias column.
+ * @param input_feat Feature matrix with bias column, not normalized.
  * @return Model outputs.
  */
-model_arr LinearRegression::output(model_arr input_feat) {
-    for(size_t c = 3; c < input_feat.shape().at(1); c += 1) {
-        ZScaleNormalizer c_norm = feat_norms.at(c);
-        xt::col(input_feat, c) = (xt::col(input_feat, c) - c_norm.mean) / c_norm.std;
-    }
-    model_arr y = xt::linalg::dot(input_feat, weights);
+model_arr LinearRegression::output(const model_arr &input_feat) const {
+    model_arr y = ML::linear_scores(input_feat, score_weights);
     return std::move(y);
 }
 
-model_arr LinearRegression::operator()(model_arr input_feat) {
+model_arr LinearRegression::operator()(const model_arr &input_feat) const {
     return output(input_feat);
 }
\ No newline at end of file
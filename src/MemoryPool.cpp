@@ -0,0 +1,145 @@
+#include "utils/MemoryPool.hpp"
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+namespace ML {
+
+bool MemoryPool::default_hugepages = false;
+thread_local MemoryPool *MemoryPool::current_pool = nullptr;
+
+static constexpr size_t hugepage_bytes = (size_t)1 << 21;
+
+static inline size_t round_up(size_t n, size_t m) {
+    return (n + m - 1) / m * m;
+}
+
+/**
+ * @brief Creates empty pool. No memory is reserved until the first allocation.
+ *
+ * @param chunk Size of the chunks small blocks are carved from.
+ * @param huge Back chunks with transparent hugepages (mmap + MADV_HUGEPAGE).
+ */
+MemoryPool::MemoryPool(size_t chunk, bool huge) {
+    hugepages = huge;
+    chunk_bytes = round_up(chunk, hugepages ? hugepage_bytes : alignment);
+}
+
+MemoryPool::~MemoryPool() {
+    for(Chunk &c : chunks)
+        free_chunk(c);
+}
+
+MemoryPool::Chunk & MemoryPool::new_chunk(size_t bytes) {
+    Chunk c{ nullptr, bytes, 0, 0, false };
+    if(hugepages) {
+        c.bytes = round_up(bytes, hugepage_bytes);
+        void *p = mmap(nullptr, c.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(p, c.bytes, MADV_HUGEPAGE);
+#endif
+            c.base = static_cast<char *>(p);
+            c.mapped = true;
+        }
+    }
+    if(c.base == nullptr)
+        c.base = static_cast<char *>(::operator new(c.bytes, std::align_val_t(alignment)));
+
+    reserved_bytes += c.bytes;
+    chunks.push_back(c);
+    return chunks.back();
+}
+
+void MemoryPool::free_chunk(Chunk &c) {
+    if(c.mapped)
+        munmap(c.base, c.bytes);
+    else
+        ::operator delete(c.base, std::align_val_t(alignment));
+    reserved_bytes -= c.bytes;
+}
+
+/**
+ * @brief Allocates 64-byte aligned block.
+ *
+ * Reuses a freed block of the same size class if there is one.
+ * Blocks larger than a quarter chunk get a dedicated chunk so they can be returned by trim().
+ *
+ * @param bytes Requested size.
+ * @return Pointer to block.
+ */
+void *MemoryPool::allocate(size_t bytes) {
+    size_t size_class = round_up(bytes + sizeof(Header), alignment);
+
+    Header *h;
+    auto reuse = free_blocks.find(size_class);
+    if(reuse != free_blocks.end() && !reuse->second.empty()) {
+        h = reuse->second.back();
+        reuse->second.pop_back();
+    } else {
+        Chunk *c;
+        if(size_class > chunk_bytes / 4) {
+            c = &new_chunk(size_class);
+        } else {
+            if(active == nullptr || active->bytes - active->used < size_class)
+                active = &new_chunk(chunk_bytes);
+            c = active;
+        }
+        h = reinterpret_cast<Header *>(c->base + c->used);
+        c->used += size_class;
+        *h = Header{ this, c, size_class };
+    }
+
+    h->chunk->live += 1;
+    return h + 1;
+}
+
+void MemoryPool::release(Header *h) {
+    h->chunk->live -= 1;
+    free_blocks[h->size_class].push_back(h);
+}
+
+/**
+ * @brief Returns chunks without live blocks to the system.
+ */
+void MemoryPool::trim() {
+    auto unused = [](const Header *h) { return h->chunk->live == 0; };
+    for(auto &[size_class, blocks] : free_blocks)
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), unused), blocks.end());
+
+    for(auto c = chunks.begin(); c != chunks.end();) {
+        if(c->live > 0) {
+            c++;
+            continue;
+        }
+        if(active == &*c)
+            active = nullptr;
+        free_chunk(*c);
+        c = chunks.erase(c);
+    }
+}
+
+/**
+ * @brief Allocates 64-byte aligned block outside of any pool.
+ */
+void *MemoryPool::heap_allocate(size_t bytes) {
+    size_t size_class = round_up(bytes + sizeof(Header), alignment);
+    Header *h = static_cast<Header *>(::operator new(size_class, std::align_val_t(alignment)));
+    *h = Header{ nullptr, nullptr, size_class };
+    return h + 1;
+}
+
+/**
+ * @brief Frees block from allocate() or heap_allocate().
+ */
+void MemoryPool::deallocate(void *p) {
+    if(p == nullptr)
+        return;
+    Header *h = static_cast<Header *>(p) - 1;
+    if(h->owner == nullptr)
+        ::operator delete(h, std::align_val_t(alignment));
+    else
+        h->owner->release(h);
+}
+
+}
@@ -0,0 +1,183 @@
+#include "Model.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "xtensor/containers/xtensor.hpp"
+#include "xtensor/generators/xbuilder.hpp"
+
+/**
+ * @brief Writes trained model to a text file.
+ *
+ * Stores everything needed for inference: label normalizer, feature statistics,
+ * feature normalizers and weights. Doubles are written with full precision.
+ *
+ * @param path Output file path.
+ * @param kind Model type tag checked by read().
+ * @return Whether the file was written.
+ */
+bool Model::write(const std::string &path, const std::string &kind) const {
+    std::ofstream f(path);
+    if(f.fail()) {
+        std::cerr << "Could not open " << path << " for writing!\n";
+        return false;
+    }
+
+    f << std::setprecision(std::numeric_limits<double>::max_digits10);
+    f << "ml-model " << kind << " 1\n";
+    f << "labels " << normalizeLabels << " " << y_norm.mean << " " << y_norm.std << "\n";
+    f << "columns " << weights.shape().at(0) << "\n";
+    f << "stats";
+    for(const ZScaleNormalizer &c_stats : feat_stats)
+        f << " " << c_stats.mean << " " << c_stats.std;
+    f << "\nnorms " << feat_norms.size();
+    for(const auto &[c, c_norm] : feat_norms)
+        f << " " << c << " " << c_norm.mean << " " << c_norm.std;
+    f << "\nweights";
+    for(size_t c = 0; c < weights.shape().at(0); c += 1)
+        f << " " << weights(c, 0);
+    f << "\n";
+    return f.good();
+}
+
+/**
+ * @brief Reads model written by write().
+ *
+ * Loaded models can only be used for inference.
+ * Files with a missing section, too few values or a normalizer outside columns [1, columns) are rejected
+ * and leave the model unchanged.
+ *
+ * @param path Model file path.
+ * @param kind Expected model type tag.
+ * @return Whether the model was read.
+ */
+bool Model::read(const std::string &path, const std::string &kind) {
+    std::string found = file_kind(path);
+    if(found != kind) {
+        if(!found.empty())
+            std::cerr << path << " is a " << found << " model, not " << kind << "!\n";
+        return false;
+    }
+
+    std::ifstream f(path);
+    std::string tag, found_kind;
+    int version = 0;
+    size_t cols = 0, n_norms = 0;
+    auto corrupt = [&path](const std::string &what) {
+        std::cerr << "Corrupt model file " << path << " (" << what << ")!\n";
+        return false;
+    };
+
+    f >> tag >> found_kind >> version;
+    if(f.fail() || version != 1)
+        return corrupt("version");
+    bool norm_labels = false;
+    ZScaleNormalizer labels_norm;
+    f >> tag >> norm_labels >> labels_norm.mean >> labels_norm.std;
+    if(f.fail() || tag != "labels")
+        return corrupt("labels");
+    f >> tag >> cols;
+    if(f.fail() || tag != "columns" || cols == 0)
+        return corrupt("columns");
+
+    // Read values one by one, so a bogus column count fails on the data instead of allocating it up front
+    f >> tag;
+    if(f.fail() || tag != "stats")
+        return corrupt("stats");
+    std::vector<ZScaleNormalizer> stats;
+    for(size_t c = 0; c < cols; c += 1) {
+        ZScaleNormalizer c_stats;
+        if(!(f >> c_stats.mean >> c_stats.std))
+            return corrupt("stats");
+        stats.push_back(c_stats);
+    }
+
+    f >> tag >> n_norms;
+    if(f.fail() || tag != "norms" || n_norms >= cols)
+        return corrupt("norms");
+    std::unordered_map<size_t, ZScaleNormalizer> norms;
+    for(size_t i = 0; i < n_norms; i += 1) {
+        size_t c;
+        ZScaleNormalizer c_norm;
+        f >> c >> c_norm.mean >> c_norm.std;
+        // Column 0 is the bias column, which is never normalized
+        if(f.fail() || c == 0 || c >= cols || !norms.insert({ c, c_norm }).second)
+            return corrupt("norms");
+    }
+
+    f >> tag;
+    if(f.fail() || tag != "weights")
+        return corrupt("weights");
+    std::vector<double> w;
+    for(size_t c = 0; c < cols; c += 1) {
+        double v;
+        if(!(f >> v))
+            return corrupt("weights");
+        w.push_back(v);
+    }
+
+    // Whole file is valid, only now touch the model
+    normalizeLabels = norm_labels;
+    y_norm = labels_norm;
+    feat_stats = std::move(stats);
+    feat_norms = std::move(norms);
+    weights = model_arr::from_shape({ cols, (size_t)1 });
+    std::copy(w.begin(), w.end(), weights.begin());
+    fold_weights();
+    n_samples = 0;
+    return true;
+}
+
+/**
+ * @brief Reads model type tag of a model file.
+ *
+ * @param path Model file path.
+ * @return Type tag ("linear_regression", "perceptron", "support_vector_machine"), empty if not a model file.
+ */
+std::string Model::file_kind(const std::string &path) {
+    std::ifstream f(path);
+    if(f.fail()) {
+        std::cerr << "Could not open model file " << path << "!\n";
+        return "";
+    }
+
+    std::string tag, kind;
+    int version = 0;
+    f >> tag >> kind >> version;
+    if(tag != "ml-model" || version != 1) {
+        std::cerr << path << " is not a model file!\n";
+        return "";
+    }
+    return kind;
+}
+
+/**
+ * @brief Folds the feature normalizers into score_weights.
+ *
+ * A normalized column contributes w[c] * (x[c] - mean) / std = (w[c] / std) * x[c] - w[c] * mean / std,
+ * so the scale goes into the column weight and the offset into the bias weight.
+ * Must be called whenever weights change, so inference never normalizes (or copies) its input.
+ */
+void Model::fold_weights() {
+    score_weights = weights;
+    if(score_weights.size() == 0)
+        return;
+    for(const auto &[c, c_norm] : feat_norms) {
+        score_weights(c, 0) /= c_norm.std;
+        score_weights(0, 0) -= score_weights(c, 0) * c_norm.mean;
+    }
+}
+
+/**
+ * @brief Weights applied directly to raw feature rows.
+ *
+ * score = w[0] + sum_c w[c] * x[c - 1] for a row x without bias column.
+ *
+ * @return Folded weights (d + 1), empty if the model has no weights.
+ */
+std::vector<double> Model::raw_weights() const {
+    return std::vector<double>(score_weights.begin(), score_weights.end());
+}
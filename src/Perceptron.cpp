@@ -1,57 +1,97 @@
 #include "Perceptron.hpp"
 #include "utils/Dataset.hpp"
-#include "xtensor/containers/xarray.hpp"
+#include "xtensor/containers/xtensor.hpp"
 #include "xtensor/generators/xbuilder.hpp"
-#include "xtensor-blas/xlinalg.hpp"
+#include "xtensor/core/xnoalias.hpp"
 
-Perceptron::Perceptron(Dataset &d, size_t start_norm) : Model(d, start_norm) {
-    weights = xt::ones<double>({ std::get<1>(fb_shape), (size_t)1 });
+Perceptron::Perceptron(Dataset &d, size_t start_norm, Communicator *comm) : Model(d, start_norm, comm) {
+    weights = xt::ones<double>({ weights.shape().at(0), (size_t)1 });
+    fold_weights();
 }
 
-double Perceptron::P_Loss(const model_arr &y_lab, const model_arr &y) {
-    if(!ML::xarray_same_shape(y_lab, y)) {
+Perceptron::Perceptron(const std::string &path) {
+    good = read(path, "perceptron");
+}
+
+template<typename A>
+double Perceptron::P_Loss(const A &y_lab, const A &y) {
+    if(!ML::same_shape(y_lab, y)) {
         std::cerr << "Not same shape!\n";
         return -1;
     }
 
-    model_arr zeros = xt::zeros_like(y_lab);
+    A zeros = xt::zeros_like(y_lab);
     double h = xt::mean(xt::maximum(zeros, -1.0 * (y_lab * y)))();;
     return h;
 }
 
+template double Perceptron::P_Loss(const model_arr &, const model_arr &);
+template double Perceptron::P_Loss(const train_arr &, const train_arr &);
+
 /**
  * @brief Trains Perceptron using feat_bias features, y_label, and weights
  * 
  * Trains weights based on the feature and label matrices using the given epoch and learning rate values.
+ * When distributed, gradients and losses are summed over all ranks every epoch.
  * 
  * @param epochs Number of time dataset will be fed into model during training
  * @param lr Step size for updating weights.
  */
 void Perceptron::train(size_t epochs, double lr) {
-    model_arr feat_bias_T = xt::transpose(*feat_bias);
-    for(size_t i = 0; i < epochs; i += 1) {
-        // Forward pass
-        model_arr y_train = xt::linalg::dot(*feat_bias, weights);
-        double loss = P_Loss(*y_label, y_train);
-        std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
-
-        // Subgradient descent (-xy)
-        model_arr mask = -1.0 * (*y_label * y_train);
-        model_arr y_grad = xt::where(mask > 0, *y_label, 0.0);
-
-        model_arr grad = (-1.0 / std::get<0>(fb_shape)) * xt::linalg::dot(feat_bias_T, y_grad);
-        weights -= lr * grad;
+    if(!has_training_data())
+        return;
+
+    // Epoch buffers go out of scope before trim(), so their chunks can be returned
+    {
+        ML::MemoryPool::Scope scope(pool.get());
+
+        // Buffers reused by every epoch
+        train_arr y_train = train_arr::from_shape(y_label.shape());
+        train_arr y_grad = train_arr::from_shape(y_label.shape());
+        train_arr grad = train_arr::from_shape(weights.shape());
+        for(size_t i = 0; i < epochs; i += 1) {
+            // Forward pass
+            forward(y_train);
+            double loss = global_mean(P_Loss(y_label, y_train));
+            if(isRoot())
+                std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
+
+            // Subgradient descent (-xy)
+            xt::noalias(y_grad) = xt::where(-1.0 * (y_label * y_train) > 0.0, y_label, 0.0);
+
+            backward(y_grad, -1.0 / n_samples, grad);
+            allreduce_grad(grad);
+            xt::noalias(weights) -= lr * grad;
+        }
     }
+    fold_weights();
     delete_feat_bias();
     delete_y_label();
+    if(pool)
+        pool->trim();
 }
 
-model_arr Perceptron::output(model_arr input_feat) {
-    model_arr raw = xt::linalg::dot(input_feat, weights);
+bool Perceptron::save(const std::string &path) const {
+    return write(path, "perceptron");
+}
+
+model_arr Perceptron::output(const model_arr &input_feat) const {
+    model_arr raw = ML::linear_scores(input_feat, score_weights);
     model_arr classes = xt::where(raw > 0.0, 1.0, -1.0);
     return std::move(classes);
 }
 
-model_arr Perceptron::operator()(model_arr input_feat) {
+/**
+ * @brief Creates int8 quantized copy of the trained classifier.
+ * 
+ * Scales are calibrated from the training feature statistics.
+ * 
+ * @return QuantizedClassifier taking the same inputs as output().
+ */
+QuantizedClassifier Perceptron::quantize() const {
+    return QuantizedClassifier(weights, feat_norms, feat_stats, false);
+}
+
+model_arr Perceptron::operator()(const model_arr &input_feat) const {
     return output(input_feat);
 }
\ No newline at end of file
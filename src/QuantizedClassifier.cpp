@@ -0,0 +1,281 @@
+#include "QuantizedClassifier.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include "xtensor/containers/xtensor.hpp"
+#include "xtensor/generators/xbuilder.hpp"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ML_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Calibrates and quantizes a trained linear classifier.
+ *
+ * Float model: score = sum_c w_c * t_c(x_c), where t_c is the z-score normalizer of column c (identity if not normalized).
+ * With x_c ~= mean_c + scale_c * q_c the score becomes K + sum_c u_c * q_c, and u is quantized to int8 with one scale s_u.
+ * The class is the sign of score, i.e. dot(q, q_weights) compared to -K / s_u.
+ *
+ * @param weights Trained weights (d + 1, 1).
+ * @param feat_norms Normalizers applied to feature columns during training.
+ * @param feat_stats Raw statistics of every training feature column (bias column included).
+ * @param zero_pos Whether a score of exactly 0 is the positive class.
+ */
+QuantizedClassifier::QuantizedClassifier(const model_arr &weights, const std::unordered_map<size_t, ZScaleNormalizer> &feat_norms,
+                                         const std::vector<ZScaleNormalizer> &feat_stats, bool zero_pos) {
+    cols = weights.shape().at(0);
+    zero_positive = zero_pos;
+    q_mean.resize(cols);
+    q_inv_scale.resize(cols);
+    q_weights.resize(cols);
+
+    // Calibrate per-column scales and fold normalization into u and K
+    double K = 0.0;
+    std::vector<double> u(cols);
+    for(size_t c = 0; c < cols; c += 1) {
+        double a = 1.0, b = 0.0;
+        auto norm = feat_norms.find(c);
+        if(norm != feat_norms.end()) {
+            a = 1.0 / norm->second.std;
+            b = -norm->second.mean / norm->second.std;
+        }
+
+        double scale = 4.0 * feat_stats.at(c).std / 127.0;
+        q_mean[c] = feat_stats.at(c).mean;
+        q_inv_scale[c] = scale > 0.0 ? 1.0 / scale : 0.0;
+
+        double w = weights(c, 0);
+        K += w * (b + a * q_mean[c]);
+        u[c] = w * a * scale;
+    }
+
+    // Quantize folded weights
+    double u_max = 0.0;
+    for(double v : u)
+        u_max = std::max(u_max, std::abs(v));
+    double s_u = u_max > 0.0 ? u_max / 127.0 : 1.0;
+    for(size_t c = 0; c < cols; c += 1)
+        q_weights[c] = (int8_t)std::lround(u[c] / s_u);
+    threshold = -K / s_u;
+}
+
+static int32_t dot_i8_tail(const int8_t *x, const int8_t *w, size_t i, size_t n, int32_t sum) {
+    for(; i < n; i += 1)
+        sum += (int32_t)x[i] * (int32_t)w[i];
+    return sum;
+}
+
+static int32_t dot_i8_scalar(const int8_t *x, const int8_t *w, size_t n) {
+    return dot_i8_tail(x, w, 0, n, 0);
+}
+
+#ifdef ML_X86_DISPATCH
+__attribute__((target("avx2"))) static int32_t hsum_epi32(__m256i acc) {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_hadd_epi32(s, s);
+    s = _mm_hadd_epi32(s, s);
+    return _mm_cvtsi128_si32(s);
+}
+
+// Both operands sign-extended to int16, multiplied and pairwise added with vpmaddwd
+__attribute__((target("avx2"))) static int32_t dot_i8_avx2(const int8_t *x, const int8_t *w, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m256i vx = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(x + i)));
+        __m256i vw = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(w + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(vx, vw));
+    }
+    return dot_i8_tail(x, w, i, n, hsum_epi32(acc));
+}
+
+// vpdpbusd multiplies unsigned by signed bytes: x is biased to x + 128 and 128 * sum(w) subtracted again
+__attribute__((target("avx2,avxvnni"))) static int32_t dot_i8_avxvnni(const int8_t *x, const int8_t *w, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    __m256i w_acc = _mm256_setzero_si256();
+    const __m256i sign = _mm256_set1_epi8((char)0x80);
+    const __m256i ones = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i vx = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(x + i)), sign);
+        __m256i vw = _mm256_loadu_si256((const __m256i *)(w + i));
+        acc = _mm256_dpbusd_avx_epi32(acc, vx, vw);
+        w_acc = _mm256_dpbusd_avx_epi32(w_acc, ones, vw);
+    }
+    acc = _mm256_sub_epi32(acc, _mm256_slli_epi32(w_acc, 7));
+    return dot_i8_tail(x, w, i, n, hsum_epi32(acc));
+}
+
+// Same as dot_i8_avxvnni with the EVEX encoded (AVX512-VNNI + AVX512VL) vpdpbusd
+__attribute__((target("avx2,avx512f,avx512vl,avx512vnni"))) static int32_t dot_i8_avx512vnni(const int8_t *x, const int8_t *w, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    __m256i w_acc = _mm256_setzero_si256();
+    const __m256i sign = _mm256_set1_epi8((char)0x80);
+    const __m256i ones = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i vx = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(x + i)), sign);
+        __m256i vw = _mm256_loadu_si256((const __m256i *)(w + i));
+        acc = _mm256_dpbusd_epi32(acc, vx, vw);
+        w_acc = _mm256_dpbusd_epi32(w_acc, ones, vw);
+    }
+    acc = _mm256_sub_epi32(acc, _mm256_slli_epi32(w_acc, 7));
+    return dot_i8_tail(x, w, i, n, hsum_epi32(acc));
+}
+#endif
+
+/**
+ * @brief Int8 dot product kernels the running CPU supports.
+ *
+ * @return Kernels from slowest to fastest, the portable scalar loop first.
+ */
+std::vector<DotI8Kernel> QuantizedClassifier::dot_i8_kernels() {
+    std::vector<DotI8Kernel> kernels = { { "scalar", dot_i8_scalar } };
+#ifdef ML_X86_DISPATCH
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        kernels.push_back({ "avx2", dot_i8_avx2 });
+    if(__builtin_cpu_supports("avxvnni"))
+        kernels.push_back({ "avxvnni", dot_i8_avxvnni });
+    if(__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vl"))
+        kernels.push_back({ "avx512vnni", dot_i8_avx512vnni });
+#endif
+    return kernels;
+}
+
+/**
+ * @brief Int8 dot product with int32 accumulation.
+ *
+ * The kernel is chosen once at runtime from the CPU features (AVX512-VNNI, AVX-VNNI, AVX2, scalar),
+ * so the same binary uses vpdpbusd where available and still runs on CPUs without AVX2.
+ *
+ * @param x Quantized features.
+ * @param w Quantized weights.
+ * @param n Number of elements.
+ * @return sum_i x[i] * w[i].
+ */
+int32_t QuantizedClassifier::dot_i8(const int8_t *x, const int8_t *w, size_t n) {
+    static const DotI8Kernel::Function kernel = dot_i8_kernels().back().fn;
+    return kernel(x, w, n);
+}
+
+/**
+ * @brief Compares quantized classes to float model classes.
+ *
+ * @param float_classes Outputs { -1, 1 } of the float model.
+ * @param quant_classes Outputs { -1, 1 } of the quantized model on the same rows.
+ * @return Number of rows, number of rows with different class, fraction of rows with the same class.
+ */
+QuantizationReport QuantizedClassifier::sign_agreement(const model_arr &float_classes, const model_arr &quant_classes) {
+    QuantizationReport r{ float_classes.size(), 0, 1.0 };
+    if(!ML::same_shape(float_classes, quant_classes)) {
+        std::cerr << "Cannot compare outputs with different shapes!\n";
+        r.agreement = std::numeric_limits<double>::quiet_NaN();
+        return r;
+    }
+
+    for(size_t i = 0; i < r.rows; i += 1)
+        if(float_classes.flat(i) != quant_classes.flat(i))
+            r.disagree += 1;
+    if(r.rows > 0)
+        r.agreement = 1.0 - (double)r.disagree / r.rows;
+    return r;
+}
+
+/**
+ * @brief Quantizes raw feature rows.
+ *
+ * @param input_feat Feature matrix with bias column (n, d + 1), not normalized.
+ * @return Quantized features (n, d + 1).
+ */
+quant_arr QuantizedClassifier::quantize(const model_arr &input_feat) const {
+    if(input_feat.shape().at(1) != cols) {
+        std::cerr << "Cannot quantize! Input has " << input_feat.shape().at(1) << " columns, model has " << cols << "!\n";
+        return quant_arr();
+    }
+
+    size_t n = input_feat.shape().at(0);
+    quant_arr q = xt::empty<int8_t>({ n, cols });
+    for(size_t i = 0; i < n; i += 1) {
+        for(size_t c = 0; c < cols; c += 1) {
+            double v = std::nearbyint((input_feat(i, c) - q_mean[c]) * q_inv_scale[c]);
+            q(i, c) = (int8_t)std::clamp(v, -127.0, 127.0);
+        }
+    }
+    return std::move(q);
+}
+
+/**
+ * @brief Quantizes raw feature rows from a buffer.
+ *
+ * Rows have no bias column: its quantized value is always 0 (constant column), so it is not stored.
+ *
+ * @param x Raw features (n_rows, num_features()), row-major.
+ * @param n_rows Number of rows.
+ * @param out Quantized features (n_rows, num_features()), row-major.
+ */
+template<typename T>
+void QuantizedClassifier::quantize_row_range(const T *x, size_t n_rows, int8_t *out) const {
+    size_t d = cols - 1;
+    for(size_t i = 0; i < n_rows; i += 1, x += d, out += d) {
+        for(size_t c = 0; c < d; c += 1) {
+            double v = std::nearbyint(((double)x[c] - q_mean[c + 1]) * q_inv_scale[c + 1]);
+            out[c] = (int8_t)std::clamp(v, -127.0, 127.0);
+        }
+    }
+}
+
+void QuantizedClassifier::quantize_rows(const double *x, size_t n_rows, int8_t *out) const {
+    quantize_row_range(x, n_rows, out);
+}
+
+void QuantizedClassifier::quantize_rows(const float *x, size_t n_rows, int8_t *out) const {
+    quantize_row_range(x, n_rows, out);
+}
+
+/**
+ * @brief Classifies quantized rows from a buffer.
+ *
+ * @param q Quantized features (n_rows, num_features()) from quantize_rows(), row-major.
+ * @param n_rows Number of rows.
+ * @param out Classes { -1, 1 } (n_rows).
+ */
+void QuantizedClassifier::classify_rows(const int8_t *q, size_t n_rows, int8_t *out) const {
+    size_t d = cols - 1;
+    for(size_t i = 0; i < n_rows; i += 1, q += d) {
+        double acc = dot_i8(q, q_weights.data() + 1, d);
+        out[i] = (acc > threshold || (zero_positive && acc == threshold)) ? 1 : -1;
+    }
+}
+
+/**
+ * @brief Classifies quantized rows.
+ *
+ * @param input_q Quantized features (n, d + 1) from quantize().
+ * @return Classes { -1, 1 } (n, 1).
+ */
+model_arr QuantizedClassifier::output(const quant_arr &input_q) const {
+    if(input_q.shape().at(1) != cols) {
+        std::cerr << "Cannot classify! Input has " << input_q.shape().at(1) << " columns, model has " << cols << "!\n";
+        return model_arr();
+    }
+
+    size_t n = input_q.shape().at(0);
+    model_arr classes = model_arr::from_shape({ n, (size_t)1 });
+    const int8_t *row = input_q.data();
+    for(size_t i = 0; i < n; i += 1, row += cols) {
+        double acc = dot_i8(row, q_weights.data(), cols);
+        classes(i, 0) = (acc > threshold || (zero_positive && acc == threshold)) ? 1.0 : -1.0;
+    }
+    return std::move(classes);
+}
+
+model_arr QuantizedClassifier::output(const model_arr &input_feat) const {
+    return output(quantize(input_feat));
+}
+
+model_arr QuantizedClassifier::operator()(const model_arr &input_feat) const {
+    return output(input_feat);
+}
@@ -1,58 +1,96 @@
 #include "SupportVectorMachine.hpp"
-#include <tuple>
-#include "xtensor/containers/xarray.hpp"
+#include "xtensor/containers/xtensor.hpp"
 #include "xtensor/generators/xbuilder.hpp"
-#include "xtensor-blas/xlinalg.hpp"
+#include "xtensor/core/xnoalias.hpp"
 #include "xtensor/core/xoperation.hpp"
 
-SupportVectorMachine::SupportVectorMachine(Dataset &d, size_t start_norm) : Model(d, start_norm) {}
+SupportVectorMachine::SupportVectorMachine(Dataset &d, size_t start_norm, Communicator *comm) : Model(d, start_norm, comm) {}
 
-double SupportVectorMachine::Hinge(const model_arr &y_lab, const model_arr &y) {
-    if(!ML::xarray_same_shape(y_lab, y)) {
+SupportVectorMachine::SupportVectorMachine(const std::string &path) {
+    good = read(path, "support_vector_machine");
+}
+
+template<typename A>
+double SupportVectorMachine::Hinge(const A &y_lab, const A &y) {
+    if(!ML::same_shape(y_lab, y)) {
         std::cerr << "Not same shape!\n";
         return -1;
     }
     
     // Hinge
-    model_arr zeros = xt::zeros_like(y_lab);
-    model_arr ones = xt::ones_like(y_lab);
+    A zeros = xt::zeros_like(y_lab);
+    A ones = xt::ones_like(y_lab);
     double h = xt::mean(xt::maximum(zeros, ones - (y_lab * y)))();;
     return h;
 }
 
+template double SupportVectorMachine::Hinge(const model_arr &, const model_arr &);
+template double SupportVectorMachine::Hinge(const train_arr &, const train_arr &);
+
 /**
  * @brief Trains SupportVectorMachine using feat_bias features, y_label, and weights
  * 
  * Trains weights based on the feature and label matrices using the given epoch and learning rate values.
+ * When distributed, gradients and losses are summed over all ranks every epoch.
  * 
  * @param epochs Number of time dataset will be fed into model during training
  * @param lr Step size for updating weights.
  */
 void SupportVectorMachine::train(size_t epochs, double lr) {
-    model_arr feat_bias_T = xt::transpose(*feat_bias);
-    for(size_t i = 0; i < epochs; i += 1) {
-        // Forward pass
-        model_arr y_train = xt::linalg::dot(*feat_bias, weights);     
-        double loss = Hinge(*y_label, y_train);
-        std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
-        
-        // Subgradient mask (-xy)
-        model_arr mask = 1.0 - (*y_label * y_train);
-        model_arr y_grad = xt::where(mask > 0.0, *y_label, 0.0);
-
-        model_arr grad = (-1.0 / std::get<0>(fb_shape)) * xt::linalg::dot(feat_bias_T, y_grad);
-        weights -= lr * grad;
+    if(!has_training_data())
+        return;
+
+    // Epoch buffers go out of scope before trim(), so their chunks can be returned
+    {
+        ML::MemoryPool::Scope scope(pool.get());
+
+        // Buffers reused by every epoch
+        train_arr y_train = train_arr::from_shape(y_label.shape());
+        train_arr y_grad = train_arr::from_shape(y_label.shape());
+        train_arr grad = train_arr::from_shape(weights.shape());
+        for(size_t i = 0; i < epochs; i += 1) {
+            // Forward pass
+            forward(y_train);
+            double loss = global_mean(Hinge(y_label, y_train));
+            if(isRoot())
+                std::cout << "Epoch: " << i + 1 << " Loss: " << loss << std::endl;
+
+            // Subgradient mask (-xy)
+            xt::noalias(y_grad) = xt::where(1.0 - (y_label * y_train) > 0.0, y_label, 0.0);
+
+            backward(y_grad, -1.0 / n_samples, grad);
+            allreduce_grad(grad);
+            xt::noalias(weights) -= lr * grad;
+        }
     }
+    fold_weights();
     delete_feat_bias();
     delete_y_label();
+    if(pool)
+        pool->trim();
 }
 
-model_arr SupportVectorMachine::output(model_arr input_feat) {
-    model_arr raw = xt::linalg::dot(input_feat, weights);
+bool SupportVectorMachine::save(const std::string &path) const {
+    return write(path, "support_vector_machine");
+}
+
+model_arr SupportVectorMachine::output(const model_arr &input_feat) const {
+    model_arr raw = ML::linear_scores(input_feat, score_weights);
     model_arr classes = xt::where(raw >= 0.0, 1.0, -1.0);
     return std::move(classes);
 }
 
-model_arr SupportVectorMachine::operator()(model_arr input_feat) {
+/**
+ * @brief Creates int8 quantized copy of the trained classifier.
+ * 
+ * Like output(), a score of exactly 0 is classified as 1.
+ * 
+ * @return QuantizedClassifier taking the same inputs as output().
+ */
+QuantizedClassifier SupportVectorMachine::quantize() const {
+    return QuantizedClassifier(weights, feat_norms, feat_stats, true);
+}
+
+model_arr SupportVectorMachine::operator()(const model_arr &input_feat) const {
     return output(input_feat);
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "ml.h"
+#include "LinearRegression.hpp"
+#include "Perceptron.hpp"
+#include "SupportVectorMachine.hpp"
+#include "Model.hpp"
+#include "QuantizedClassifier.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ModelKind { LinearRegression, Perceptron, SupportVectorMachine };
+
+/*
+ * Everything needed for scoring, copied out of the model once at load time.
+ * Normalizers and bias are folded into the weights (Model::raw_weights),
+ * so a row is scored straight from the caller's buffer.
+ * Classifiers also keep an int8 copy for ml_quantize_batch / ml_predict_batch_i8.
+ */
+struct ml_model {
+    ModelKind kind;
+    std::vector<double> weights;    // (d + 1), weights[0] is bias
+    double y_mean = 0.0;            // Label denormalization (regression)
+    double y_std = 1.0;
+    std::unique_ptr<QuantizedClassifier> quant;    // Int8 scoring (classifiers)
+};
+
+template<typename T>
+static int predict_rows(const ml_model *model, const T *x, size_t n_rows, size_t n_cols, T *out) {
+    if(model == nullptr || (n_rows > 0 && (x == nullptr || out == nullptr)))
+        return ML_ERR_ARG;
+    if(n_cols + 1 != model->weights.size())
+        return ML_ERR_SHAPE;
+
+    const double *w = model->weights.data();
+    for(size_t i = 0; i < n_rows; i += 1) {
+        const T *row = x + i * n_cols;
+        double s = w[0];
+        for(size_t c = 0; c < n_cols; c += 1)
+            s += w[c + 1] * (double)row[c];
+
+        switch(model->kind) {
+            case ModelKind::LinearRegression:       out[i] = (T)(s * model->y_std + model->y_mean); break;
+            case ModelKind::Perceptron:             out[i] = s > 0.0 ? (T)1 : (T)-1; break;
+            case ModelKind::SupportVectorMachine:   out[i] = s >= 0.0 ? (T)1 : (T)-1; break;
+        }
+    }
+    return ML_OK;
+}
+
+template<typename T>
+static int quantize_rows(const ml_model *model, const T *x, size_t n_rows, size_t n_cols, int8_t *out) {
+    if(model == nullptr || (n_rows > 0 && (x == nullptr || out == nullptr)))
+        return ML_ERR_ARG;
+    if(model->quant == nullptr)
+        return ML_ERR_KIND;
+    if(n_cols != model->quant->num_features())
+        return ML_ERR_SHAPE;
+
+    model->quant->quantize_rows(x, n_rows, out);
+    return ML_OK;
+}
+
+extern "C" {
+
+/*
+ * No exception may cross the C boundary: every entry point catches everything
+ * (including std::bad_alloc) and reports it through its return value.
+ */
+
+ml_model *ml_model_load(const char *path) {
+    if(path == nullptr)
+        return nullptr;
+
+    try {
+        std::string kind = Model::file_kind(path);
+        std::unique_ptr<ml_model> model = std::make_unique<ml_model>();
+        if(kind == "linear_regression") {
+            LinearRegression m{ std::string(path) };
+            if(!m.isGood())
+                return nullptr;
+            model->kind = ModelKind::LinearRegression;
+            model->weights = m.raw_weights();
+            if(m.labelsNormalized()) {
+                model->y_mean = m.getYMean();
+                model->y_std = m.getYSTD();
+            }
+        } else if(kind == "perceptron") {
+            Perceptron m{ std::string(path) };
+            if(!m.isGood())
+                return nullptr;
+            model->kind = ModelKind::Perceptron;
+            model->weights = m.raw_weights();
+            model->quant = std::make_unique<QuantizedClassifier>(m.quantize());
+        } else if(kind == "support_vector_machine") {
+            SupportVectorMachine m{ std::string(path) };
+            if(!m.isGood())
+                return nullptr;
+            model->kind = ModelKind::SupportVectorMachine;
+            model->weights = m.raw_weights();
+            model->quant = std::make_unique<QuantizedClassifier>(m.quantize());
+        }
+
+        if(model->weights.empty())
+            return nullptr;
+        return model.release();
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+void ml_model_free(ml_model *model) {
+    delete model;
+}
+
+size_t ml_model_num_features(const ml_model *model) {
+    return model == nullptr ? 0 : model->weights.size() - 1;
+}
+
+int ml_predict_batch(const ml_model *model, const double *x, size_t n_rows, size_t n_cols, double *out) {
+    try {
+        return predict_rows(model, x, n_rows, n_cols, out);
+    } catch(...) {
+        return ML_ERR_INTERNAL;
+    }
+}
+
+int ml_predict_batch_f32(const ml_model *model, const float *x, size_t n_rows, size_t n_cols, float *out) {
+    try {
+        return predict_rows(model, x, n_rows, n_cols, out);
+    } catch(...) {
+        return ML_ERR_INTERNAL;
+    }
+}
+
+int ml_quantize_batch(const ml_model *model, const double *x, size_t n_rows, size_t n_cols, int8_t *out) {
+    try {
+        return quantize_rows(model, x, n_rows, n_cols, out);
+    } catch(...) {
+        return ML_ERR_INTERNAL;
+    }
+}
+
+int ml_quantize_batch_f32(const ml_model *model, const float *x, size_t n_rows, size_t n_cols, int8_t *out) {
+    try {
+        return quantize_rows(model, x, n_rows, n_cols, out);
+    } catch(...) {
+        return ML_ERR_INTERNAL;
+    }
+}
+
+int ml_predict_batch_i8(const ml_model *model, const int8_t *q, size_t n_rows, size_t n_cols, int8_t *out) {
+    try {
+        if(model == nullptr || (n_rows > 0 && (q == nullptr || out == nullptr)))
+            return ML_ERR_ARG;
+        if(model->quant == nullptr)
+            return ML_ERR_KIND;
+        if(n_cols != model->quant->num_features())
+            return ML_ERR_SHAPE;
+
+        model->quant->classify_rows(q, n_rows, out);
+        return ML_OK;
+    } catch(...) {
+        return ML_ERR_INTERNAL;
+    }
+}
+
+}
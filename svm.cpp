@@ -1,10 +1,13 @@
 #include "utils/Dataset.hpp"
 #include "SupportVectorMachine.hpp"
 #include "utils/ML_CLIOptions.hpp"
+#include "utils/Communicator.hpp"
 #include <iostream>
-#include "xtensor/containers/xarray.hpp"
+#include <memory>
+#include <stdexcept>
+#include "xtensor/containers/xtensor.hpp"
 
-void validation(SupportVectorMachine &, std::string, bool);
+void validation(SupportVectorMachine &, std::string, bool, bool);
 
 int main(int argc, char **argv) {
     ML_CLIOptions cli;
@@ -17,39 +20,75 @@ int main(int argc, char **argv) {
 
     bool no_header = cli.vm["no-header"].as<bool>();
     std::string input = cli.vm["input-file"].as<std::string>();
+    size_t rank = cli.vm["rank"].as<size_t>();
+    size_t world_size = cli.vm["world-size"].as<size_t>();
 
-    // Load dataset
-    Dataset data(input);
+    // Connect to other ranks
+    std::unique_ptr<SocketCommunicator> comm;
+    if(world_size > 1) {
+        comm = std::make_unique<SocketCommunicator>(cli.vm["dist-addr"].as<std::string>(), rank, world_size,
+                                                    cli.vm["dist-timeout"].as<double>());
+        if(!comm->isGood()) {
+            std::cerr << "Could not connect to other ranks!\n";
+            return -1;
+        }
+    }
+
+    // Load dataset (this rank's shard)
+    Dataset data(input, no_header, rank, world_size);
     if(!data.isGood()) {
         std::cerr << "Could not open CSV!\n";
         return -1;
     }
 
     // Create SVM
-    SupportVectorMachine svm(data, 28);
+    ML::MemoryPool::set_default_hugepages(cli.vm["hugepages"].as<bool>());
+    try {
+        SupportVectorMachine svm(data, 28, comm.get());
+        if(!svm.isGood())
+            return -1;
 
-    // Train
-    size_t epochs = cli.vm["epochs"].as<size_t>();
-    double lr = cli.vm["lr"].as<double>();
-    std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
-    svm.train(epochs, lr);
+        // Train
+        size_t epochs = cli.vm["epochs"].as<size_t>();
+        double lr = cli.vm["lr"].as<double>();
+        if(svm.isRoot())
+            std::cout << "Training with epochs=" << epochs << " lr=" << lr << std::endl;
+        svm.train(epochs, lr);
 
-    if(cli.vm.count("test-file"))
-        validation(svm, cli.vm["test-file"].as<std::string>(), no_header);
+        // Save model
+        std::string model_file = cli.vm["save-model"].as<std::string>();
+        if(svm.isRoot() && !model_file.empty() && !svm.save(model_file))
+            std::cerr << "Could not save model!\n";
+
+        if(svm.isRoot() && cli.vm.count("test-file"))
+            validation(svm, cli.vm["test-file"].as<std::string>(), no_header, cli.vm["quantize"].as<bool>());
+    } catch(const std::exception &e) {
+        // Lost a neighbouring rank during training
+        std::cerr << e.what() << "\n";
+        return -1;
+    }
 
     return 0;
 }
 
-void validation(SupportVectorMachine &svm, std::string val_file, bool no_header) {
+void validation(SupportVectorMachine &svm, std::string val_file, bool no_header, bool quantize) {
     Dataset val_data(val_file);
     if(!val_data.isGood()) {
         std::cerr << "Could not open validation dataset!\n";
         return;
     }
 
-    xt::xarray<double> f = ML::generate_feat_bias(val_data.get_features());
-    xt::xarray<double> labels = val_data.get_labels();
-    xt::xarray<double> outputs = svm(f);
+    model_arr f = ML::generate_feat_bias(val_data.get_features());
+    model_arr labels = val_data.get_labels();
+    model_arr outputs = svm(f);
     std::cout << "Mean Hinge Loss: " << SupportVectorMachine::Hinge(labels, outputs) << std::endl;
     std::cout << "Accuracy       : " << ML::accuracy(labels, outputs) << std::endl;
+
+    if(quantize) {
+        QuantizedClassifier q = svm.quantize();
+        model_arr outputs_q = q(f);
+        QuantizationReport r = QuantizedClassifier::sign_agreement(outputs, outputs_q);
+        std::cout << "Accuracy (int8): " << ML::accuracy(labels, outputs_q) << std::endl
+                  << "Sign agreement : " << r.agreement << " (" << r.disagree << "/" << r.rows << " rows differ)" << std::endl;
+    }
 }
\ No newline at end of file
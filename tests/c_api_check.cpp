@@ -0,0 +1,138 @@
+#include "ml.h"
+#include "LinearRegression.hpp"
+#include "Model.hpp"
+#include "Perceptron.hpp"
+#include "QuantizedClassifier.hpp"
+#include "utils/Dataset.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Trains a small Perceptron, saves it and checks that the C API (ml.h)
+ * loads it and predicts the same classes as Perceptron::output. The int8 path must match
+ * QuantizedClassifier and agree with the float model on the separable grid.
+ */
+
+static int failures = 0;
+
+// Exposes Model::read, to reload a model that already holds one
+class LinearRegressionProbe : public LinearRegression {
+public:
+    using LinearRegression::LinearRegression;
+    bool reload(const std::string &path) { return read(path, "linear_regression"); }
+};
+
+static void check(bool ok, const std::string &what) {
+    if(!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures += 1;
+    }
+}
+
+int main() {
+    const std::string csv_file = "c_api_check.csv";
+    const std::string model_file = "c_api_check.model";
+    const std::string corrupt_file = "c_api_check_corrupt.model";
+    const size_t n_rows = 64, n_cols = 2;
+
+    // Linearly separable data on a grid
+    {
+        std::ofstream f(csv_file);
+        f << "x0,x1,y\n";
+        for(size_t i = 0; i < n_rows; i += 1) {
+            double x0 = (double)(i % 8) - 3.5, x1 = (double)(i / 8) * 0.5 - 1.0;
+            f << x0 << "," << x1 << "," << (2.0 * x0 - x1 + 0.3 > 0.0 ? 1 : -1) << "\n";
+        }
+    }
+
+    Dataset data(csv_file, false);
+    check(data.isGood(), "load training CSV");
+    Perceptron p(data, 0);
+    check(p.isGood(), "create Perceptron");
+    p.train(50, 0.1);
+    check(p.save(model_file), "save model");
+
+    ml_model *m = ml_model_load(model_file.c_str());
+    check(m != nullptr, "ml_model_load");
+    if(m == nullptr)
+        return 1;
+    check(ml_model_num_features(m) == n_cols, "ml_model_num_features");
+
+    // Compare to the C++ model on the training rows
+    Dataset rows(csv_file, false);
+    model_arr feat = rows.get_features();
+    model_arr expected = p(ML::generate_feat_bias(feat));
+    std::vector<double> w = p.raw_weights();
+    std::vector<double> out(n_rows);
+    std::vector<float> feat_f32(feat.begin(), feat.end()), out_f32(n_rows);
+    check(ml_predict_batch(m, feat.data(), n_rows, n_cols, out.data()) == ML_OK, "ml_predict_batch");
+    check(ml_predict_batch_f32(m, feat_f32.data(), n_rows, n_cols, out_f32.data()) == ML_OK, "ml_predict_batch_f32");
+    for(size_t i = 0; i < n_rows; i += 1) {
+        // Folded and unfolded weights may round differently right on the decision boundary
+        double score = w[0] + w[1] * feat(i, 0) + w[2] * feat(i, 1);
+        if(std::abs(score) < 1e-9)
+            continue;
+        check(out[i] == expected(i, 0), "ml_predict_batch row " + std::to_string(i));
+        check(out_f32[i] == (float)expected(i, 0) || std::abs(score) < 1e-5, "ml_predict_batch_f32 row " + std::to_string(i));
+    }
+
+    // Int8 path matches QuantizedClassifier on the same rows
+    model_arr expected_q = p.quantize()(ML::generate_feat_bias(feat));
+    std::vector<int8_t> q(n_rows * n_cols), out_i8(n_rows);
+    check(ml_quantize_batch(m, feat.data(), n_rows, n_cols, q.data()) == ML_OK, "ml_quantize_batch");
+    check(ml_predict_batch_i8(m, q.data(), n_rows, n_cols, out_i8.data()) == ML_OK, "ml_predict_batch_i8");
+    for(size_t i = 0; i < n_rows; i += 1)
+        check(out_i8[i] == (int8_t)expected_q(i, 0), "ml_predict_batch_i8 row " + std::to_string(i));
+
+    // Calibration: int8 classes agree with the float model (a broken scale or threshold lands near 0.5)
+    QuantizationReport agreement = QuantizedClassifier::sign_agreement(expected, expected_q);
+    check(agreement.agreement >= 0.9, "int8 sign agreement with float model is " + std::to_string(agreement.agreement));
+
+    // Errors
+    check(ml_predict_batch_i8(m, q.data(), n_rows, n_cols + 1, out_i8.data()) == ML_ERR_SHAPE, "int8 column count mismatch");
+    check(ml_predict_batch_i8(nullptr, q.data(), n_rows, n_cols, out_i8.data()) == ML_ERR_ARG, "int8 NULL model");
+    check(ml_predict_batch(m, feat.data(), n_rows, n_cols + 1, out.data()) == ML_ERR_SHAPE, "column count mismatch");
+    check(ml_predict_batch(m, nullptr, n_rows, n_cols, out.data()) == ML_ERR_ARG, "NULL input");
+    check(ml_model_load("c_api_check_missing.model") == nullptr, "missing model file");
+    {
+        // Normalizer on the bias column
+        std::ofstream f(corrupt_file);
+        f << "ml-model perceptron 1\nlabels 0 0 1\ncolumns 3\nstats 1 0 0 1 0 1\nnorms 1 0 0 1\nweights 1 1 1\n";
+    }
+    check(ml_model_load(corrupt_file.c_str()) == nullptr, "normalizer on bias column");
+    {
+        // Fewer weights than columns
+        std::ofstream f(corrupt_file);
+        f << "ml-model perceptron 1\nlabels 0 0 1\ncolumns 3\nstats 1 0 0 1 0 1\nnorms 0\nweights 1 1\n";
+    }
+    check(ml_model_load(corrupt_file.c_str()) == nullptr, "truncated weights");
+
+    // A rejected file leaves an already loaded model unchanged
+    {
+        std::ofstream f(corrupt_file);
+        f << "ml-model linear_regression 1\nlabels 1 2 3\ncolumns 2\nstats 1 0 0 1\nnorms 0\nweights 0.5 2\n";
+    }
+    LinearRegressionProbe lin_reg{ corrupt_file };
+    check(lin_reg.isGood(), "load linear regression");
+    {
+        std::ofstream f(corrupt_file);
+        f << "ml-model linear_regression 1\nlabels 0 7 9\ncolumns 2\nstats 1 0 0 1\nnorms 1 1 5 5\nweights 1\n";
+    }
+    check(!lin_reg.reload(corrupt_file), "reload truncated linear regression");
+    check(lin_reg.labelsNormalized() && lin_reg.getYMean() == 2.0 && lin_reg.getYSTD() == 3.0, "label normalizer unchanged after rejected file");
+    check(lin_reg.raw_weights() == std::vector<double>({ 0.5, 2.0 }), "weights unchanged after rejected file");
+
+    ml_model_free(m);
+    std::remove(csv_file.c_str());
+    std::remove(model_file.c_str());
+    std::remove(corrupt_file.c_str());
+
+    if(failures == 0)
+        std::cout << "c_api_check passed\n";
+    return failures == 0 ? 0 : 1;
+}
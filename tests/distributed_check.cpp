@@ -0,0 +1,131 @@
+#include "LinearRegression.hpp"
+#include "Perceptron.hpp"
+#include "SupportVectorMachine.hpp"
+#include "utils/Communicator.hpp"
+#include "utils/Dataset.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Forks `world` ranks that train LinearRegression, Perceptron and SupportVectorMachine
+ * over a unix: SocketCommunicator, each on its own shard of the CSV.
+ * Every rank also trains the same model in a single process on the whole CSV
+ * and checks that both runs end with the same weights.
+ */
+
+static const size_t world = 3;
+static const size_t n_rows = 101;       // Not a multiple of world, so shards differ in size
+static const size_t epochs = 20;
+static const double lr = 0.1;
+static const double tolerance = 1e-9;
+
+static void write_csv(const std::string &path, bool classes) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> x(-2.0, 2.0), noise(-0.5, 0.5);
+    std::ofstream f(path);
+    f << std::setprecision(std::numeric_limits<double>::max_digits10);
+    f << "x0,x1,x2,y\n";
+    for(size_t i = 0; i < n_rows; i += 1) {
+        double x0 = x(gen), x1 = 10.0 * x(gen), x2 = x(gen) + 5.0;
+        double y = 3.0 + 2.0 * x0 - 0.3 * x1 + 0.5 * x2 + noise(gen);
+        if(classes)
+            y = y > 3.5 ? 1.0 : -1.0;
+        f << x0 << "," << x1 << "," << x2 << "," << y << "\n";
+    }
+}
+
+static std::vector<double> train(const std::string &kind, Dataset &d, Communicator *comm) {
+    if(kind == "linear_regression") {
+        LinearRegression m(d, true, 0, comm);
+        m.train(epochs, lr);
+        return m.raw_weights();
+    } else if(kind == "perceptron") {
+        Perceptron m(d, 0, comm);
+        m.train(epochs, lr);
+        return m.raw_weights();
+    }
+    SupportVectorMachine m(d, 0, comm);
+    m.train(epochs, lr);
+    return m.raw_weights();
+}
+
+static bool same_weights(const std::vector<double> &a, const std::vector<double> &b) {
+    if(a.size() != b.size() || a.empty())
+        return false;
+    for(size_t c = 0; c < a.size(); c += 1)
+        if(std::abs(a[c] - b[c]) > tolerance * std::max(1.0, std::abs(b[c])))
+            return false;
+    return true;
+}
+
+static int run_rank(const std::string &addr, size_t rank, const std::string &reg_csv, const std::string &class_csv) {
+    SocketCommunicator comm(addr, rank, world, 30.0);
+    if(!comm.isGood())
+        return 1;
+
+    int failures = 0;
+    for(const std::string kind : { "linear_regression", "perceptron", "support_vector_machine" }) {
+        const std::string &csv = kind == "linear_regression" ? reg_csv : class_csv;
+        Dataset shard(csv, false, rank, world);
+        Dataset full(csv, false);
+        std::vector<double> distributed = train(kind, shard, &comm);
+        std::vector<double> single = train(kind, full, nullptr);
+        if(!same_weights(distributed, single)) {
+            std::cerr << "FAILED: rank " << rank << " " << kind << " weights differ from single-process training\n";
+            failures += 1;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    std::string id = std::to_string(getpid());
+    std::string reg_csv = "distributed_check_reg." + id + ".csv";
+    std::string class_csv = "distributed_check_class." + id + ".csv";
+    std::string addr = "unix:/tmp/ml_distributed_check." + id;
+    write_csv(reg_csv, false);
+    write_csv(class_csv, true);
+
+    std::vector<pid_t> ranks;
+    for(size_t rank = 0; rank < world; rank += 1) {
+        pid_t pid = fork();
+        if(pid == 0) {
+            int failures = 1;
+            try {
+                failures = run_rank(addr, rank, reg_csv, class_csv);
+            } catch(const std::exception &e) {
+                std::cerr << "FAILED: rank " << rank << ": " << e.what() << "\n";
+            }
+            std::cout.flush();
+            _exit(failures == 0 ? 0 : 1);
+        }
+        if(pid < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        ranks.push_back(pid);
+    }
+
+    bool passed = true;
+    for(pid_t pid : ranks) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        passed = passed && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    std::remove(reg_csv.c_str());
+    std::remove(class_csv.c_str());
+
+    if(passed)
+        std::cout << "distributed_check passed\n";
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include "QuantizedClassifier.hpp"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Checks every int8 dot product kernel the CPU supports (and the dispatched QuantizedClassifier::dot_i8)
+ * against a plain loop, for every length up to several vector widths, including the scalar tails.
+ */
+
+static int32_t reference_dot(const int8_t *x, const int8_t *w, size_t n) {
+    int32_t sum = 0;
+    for(size_t i = 0; i < n; i += 1)
+        sum += (int32_t)x[i] * (int32_t)w[i];
+    return sum;
+}
+
+int main() {
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> value(-128, 127);
+    std::vector<DotI8Kernel> kernels = QuantizedClassifier::dot_i8_kernels();
+
+    const size_t max_n = 600;
+    std::vector<int8_t> x(max_n + 1), w(max_n + 1);
+    for(size_t k = 0; k <= max_n; k += 1) {
+        x[k] = (int8_t)value(gen);
+        w[k] = (int8_t)value(gen);
+    }
+
+    int failures = 0;
+    for(size_t n = 0; n <= max_n; n += 1) {
+        // Odd offset, so vector loads are unaligned
+        const int8_t *xs = x.data() + 1, *ws = w.data() + (n % 2);
+        int32_t expected = reference_dot(xs, ws, n);
+        for(const DotI8Kernel &k : kernels) {
+            if(k.fn(xs, ws, n) != expected) {
+                std::cerr << "FAILED: " << k.name << " n=" << n << "\n";
+                failures += 1;
+            }
+        }
+        if(QuantizedClassifier::dot_i8(xs, ws, n) != expected) {
+            std::cerr << "FAILED: dot_i8 n=" << n << "\n";
+            failures += 1;
+        }
+    }
+
+    // Saturated values, where the unsigned bias of vpdpbusd matters most
+    std::vector<int8_t> lo(max_n, -128), hi(max_n, 127);
+    for(const DotI8Kernel &k : kernels) {
+        if(k.fn(lo.data(), hi.data(), max_n) != reference_dot(lo.data(), hi.data(), max_n)
+           || k.fn(lo.data(), lo.data(), max_n) != reference_dot(lo.data(), lo.data(), max_n)) {
+            std::cerr << "FAILED: " << k.name << " saturated values\n";
+            failures += 1;
+        }
+    }
+
+    std::cout << "Kernels:";
+    for(const DotI8Kernel &k : kernels)
+        std::cout << " " << k.name;
+    std::cout << "\n";
+    if(failures == 0)
+        std::cout << "dot_i8_check passed\n";
+    return failures == 0 ? 0 : 1;
+}
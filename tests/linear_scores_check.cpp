@@ -0,0 +1,91 @@
+#include "LinearRegression.hpp"
+#include "Model.hpp"
+#include "utils/Dataset.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include "xtensor/containers/xtensor.hpp"
+#include "xtensor/views/xview.hpp"
+#include "xtensor-blas/xlinalg.hpp"
+
+/*
+ * Checks ML::linear_scores (unrolled linear_scores_fixed<D> for 2 to 8 columns) against BLAS,
+ * and LinearRegression::output (normalizers folded into the weights) against normalizing the input first.
+ */
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    if(!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures += 1;
+    }
+}
+
+static bool close_to(const model_arr &a, const model_arr &b, double tolerance) {
+    if(!ML::same_shape(a, b))
+        return false;
+    for(size_t i = 0; i < a.size(); i += 1)
+        if(std::abs(a.flat(i) - b.flat(i)) > tolerance * std::max(1.0, std::abs(b.flat(i))))
+            return false;
+    return true;
+}
+
+// Scores the way inference worked before folding: normalize a copy of the input, then multiply by the trained weights
+class LinearRegressionProbe : public LinearRegression {
+public:
+    using LinearRegression::LinearRegression;
+
+    model_arr normalized_output(model_arr input_feat) const {
+        for(const auto &[c, c_norm] : feat_norms)
+            xt::col(input_feat, c) = (xt::col(input_feat, c) - c_norm.mean) / c_norm.std;
+        return xt::linalg::dot(input_feat, weights);
+    }
+};
+
+int main() {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> value(-3.0, 3.0);
+
+    // Fixed-width kernels (2 to 8) and the BLAS fallback on either side
+    for(size_t d = 1; d <= 10; d += 1) {
+        for(size_t n : { (size_t)1, (size_t)37 }) {
+            model_arr input_feat = model_arr::from_shape({ n, d });
+            model_arr weights = model_arr::from_shape({ d, (size_t)1 });
+            for(double &v : input_feat)
+                v = value(gen);
+            for(double &v : weights)
+                v = value(gen);
+
+            model_arr expected = xt::linalg::dot(input_feat, weights);
+            model_arr scores = ML::linear_scores(input_feat, weights);
+            check(close_to(scores, expected, 1e-12), "linear_scores d=" + std::to_string(d) + " n=" + std::to_string(n));
+        }
+    }
+
+    // Folded normalizers
+    const std::string csv_file = "linear_scores_check.csv";
+    {
+        std::ofstream f(csv_file);
+        f << "x0,x1,x2,y\n";
+        for(size_t i = 0; i < 50; i += 1) {
+            double x0 = value(gen), x1 = 100.0 + 20.0 * value(gen), x2 = 0.01 * value(gen);
+            f << x0 << "," << x1 << "," << x2 << "," << 1.0 + 2.0 * x0 - 0.05 * x1 + 30.0 * x2 << "\n";
+        }
+    }
+    Dataset data(csv_file, false);
+    check(data.isGood(), "load training CSV");
+    LinearRegressionProbe lin_reg(data, true, 0);
+    lin_reg.train(30, 0.1);
+    model_arr input_feat = ML::generate_feat_bias(data.get_features());
+    check(close_to(lin_reg.output(input_feat), lin_reg.normalized_output(input_feat), 1e-9), "LinearRegression::output with folded normalizers");
+    std::remove(csv_file.c_str());
+
+    if(failures == 0)
+        std::cout << "linear_scores_check passed\n";
+    return failures == 0 ? 0 : 1;
+}
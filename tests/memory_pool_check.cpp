@@ -0,0 +1,155 @@
+#include "utils/MemoryPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Checks MemoryPool and PoolAllocator: block reuse across training-style iterations, 64-byte alignment,
+ * trim(), freeing through another allocator or pool, Scope routing and the hugepage (mmap) path.
+ */
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    if(!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures += 1;
+    }
+}
+
+static bool aligned(const void *p) {
+    return (uintptr_t)p % ML::MemoryPool::alignment == 0;
+}
+
+int main() {
+    const size_t chunk = (size_t)1 << 16;
+    const size_t hugepage = (size_t)1 << 21;
+
+    // Same-size blocks are reused every iteration without growing the pool
+    {
+        ML::MemoryPool pool(chunk, false);
+        ML::PoolAllocator<double> alloc(&pool);
+        std::vector<double *> first;
+        size_t reserved = 0;
+        for(size_t epoch = 0; epoch < 5; epoch += 1) {
+            std::vector<double *> blocks;
+            for(size_t n : { 100, 100, 1, 333 })          // Like y_train, residual, loss and grad
+                blocks.push_back(alloc.allocate(n));
+            std::sort(blocks.begin(), blocks.end());    // Same-size blocks come back in either order
+            if(epoch == 0) {
+                first = blocks;
+                reserved = pool.reserved();
+            } else {
+                check(blocks == first, "blocks reused in epoch " + std::to_string(epoch));
+                check(pool.reserved() == reserved, "no new chunk in epoch " + std::to_string(epoch));
+            }
+            for(double *p : blocks)
+                alloc.deallocate(p, 0);
+        }
+        check(reserved == chunk, "small blocks share one chunk");
+    }
+
+    // Every block is 64-byte aligned, including blocks with a dedicated chunk and heap blocks
+    {
+        ML::MemoryPool pool(chunk, false);
+        ML::PoolAllocator<char> alloc(&pool), heap(nullptr);
+        std::vector<char *> blocks;
+        for(size_t n = 1; n <= 200; n += 7)
+            blocks.push_back(alloc.allocate(n));
+        blocks.push_back(alloc.allocate(chunk));
+        for(char *p : blocks)
+            check(aligned(p), "pool block alignment");
+        char *h = heap.allocate(13);
+        check(aligned(h), "heap block alignment");
+        heap.deallocate(h, 13);
+        for(char *p : blocks)
+            alloc.deallocate(p, 0);
+    }
+
+    // trim() keeps chunks with live blocks and returns the rest
+    {
+        ML::MemoryPool pool(chunk, false);
+        ML::PoolAllocator<double> alloc(&pool);
+        double *small = alloc.allocate(16);
+        double *large = alloc.allocate(chunk);     // Larger than a quarter chunk: dedicated chunk
+        check(pool.reserved() > chunk, "large block gets its own chunk");
+        alloc.deallocate(large, 0);
+        pool.trim();
+        check(pool.reserved() == chunk, "trim() returns the free dedicated chunk");
+        small[15] = 1.0;
+        alloc.deallocate(small, 0);
+        pool.trim();
+        check(pool.reserved() == 0, "trim() returns every chunk once all blocks are freed");
+        double *again = alloc.allocate(16);
+        check(pool.reserved() == chunk && aligned(again), "pool usable after trim()");
+        alloc.deallocate(again, 0);
+    }
+
+    // Blocks go back to their owner whichever allocator or pool frees them
+    {
+        ML::MemoryPool a(chunk, false), b(chunk, false);
+        ML::PoolAllocator<double> from_a(&a), from_b(&b), heap(nullptr);
+        double *p = from_a.allocate(32);
+        from_b.deallocate(p, 32);
+        check(b.reserved() == 0, "freeing through another pool does not touch it");
+        check(from_a.allocate(32) == p, "block freed through another pool is reused by its owner");
+        from_a.deallocate(p, 32);
+
+        double *h = heap.allocate(32);
+        from_a.deallocate(h, 32);
+        double *q = ML::PoolAllocator<double>(&b).allocate(32);
+        ML::PoolAllocator<double>(from_a).deallocate(q, 32);
+        check(ML::PoolAllocator<float>(from_b).pool == &b, "rebound allocator keeps its pool");
+        check(b.allocate(32 * sizeof(double)) == q, "block freed through a copied allocator is reused by its owner");
+        ML::MemoryPool::deallocate(q);
+        a.trim();
+        b.trim();
+        check(a.reserved() == 0 && b.reserved() == 0, "both pools empty after trim()");
+    }
+
+    // Default constructed allocators follow the innermost Scope
+    {
+        ML::MemoryPool pool(chunk, false);
+        check(ML::PoolAllocator<double>().pool == nullptr, "heap without a Scope");
+        {
+            ML::MemoryPool::Scope scope(&pool);
+            check(ML::PoolAllocator<double>().pool == &pool, "pool inside a Scope");
+            {
+                ML::MemoryPool::Scope heap(nullptr);
+                check(ML::PoolAllocator<double>().pool == nullptr, "heap inside a nested nullptr Scope");
+            }
+            std::vector<double, ML::PoolAllocator<double>> v(1000, 2.0);
+            check(pool.reserved() > 0 && aligned(v.data()), "std::vector allocates from the Scope pool");
+        }
+        check(ML::MemoryPool::current() == nullptr, "Scope restored on exit");
+        pool.trim();
+        check(pool.reserved() == 0, "vector storage returned by trim()");
+    }
+
+    // Hugepage path: chunks are mmap'ed in whole 2 MiB pages
+    {
+        ML::MemoryPool pool(chunk, true);
+        ML::PoolAllocator<char> alloc(&pool);
+        char *small = alloc.allocate(4096);
+        check(pool.reserved() == hugepage, "hugepage chunk rounded up to 2 MiB");
+        char *large = alloc.allocate(hugepage + 1);
+        check(pool.reserved() == 3 * hugepage, "dedicated hugepage chunk rounded up to 2 MiB");
+        check(aligned(small) && aligned(large), "hugepage block alignment");
+        std::memset(small, 1, 4096);
+        std::memset(large, 2, hugepage + 1);
+        check(small[4095] == 1 && large[hugepage] == 2, "hugepage blocks are writable");
+        alloc.deallocate(large, 0);
+        check(alloc.allocate(hugepage + 1) == large, "hugepage block reused");
+        alloc.deallocate(large, 0);
+        alloc.deallocate(small, 0);
+        pool.trim();
+        check(pool.reserved() == 0, "trim() unmaps hugepage chunks");
+    }
+
+    if(failures == 0)
+        std::cout << "memory_pool_check passed\n";
+    return failures == 0 ? 0 : 1;
+}